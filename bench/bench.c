@@ -0,0 +1,1076 @@
+/*
+* MIT License
+*
+* Copyright (c) 2023 Zachary Tabikh
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+//Every allocation the reader makes goes through these, so each benchmark can report allocations/op.
+static unsigned long bench_allocs;
+
+//Counted atomically where possible, as the batch benchmarks' threads allocate too
+#ifdef __GNUC__
+#define BENCH_COUNT_ALLOC() __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED)
+#else
+#define BENCH_COUNT_ALLOC() bench_allocs++
+#endif
+
+static void * bench_malloc(size_t size)
+{
+	BENCH_COUNT_ALLOC();
+	return malloc(size);
+}
+
+static void * bench_realloc(void * ptr, size_t size)
+{
+	BENCH_COUNT_ALLOC();
+	return realloc(ptr, size);
+}
+
+#ifdef JSMNR_NO_HEAP
+#error "The benchmarks compare against the allocating getters, so they can't be built with JSMNR_NO_HEAP"
+#endif
+
+#define malloc(size) bench_malloc(size)
+#define realloc(ptr, size) bench_realloc(ptr, size)
+#include "../jsmnreader.h"
+#undef malloc
+#undef realloc
+
+/* ---- CORPUS GENERATORS ---- */
+
+typedef struct bench_buf_struct
+{
+	char * data;
+	size_t len;
+	size_t cap;
+} bench_buf;
+
+static void bench_buf_printf(bench_buf * buf, const char * fmt, ...)
+{
+	va_list args;
+	int n;
+	for (;;)
+	{
+		va_start(args, fmt);
+		n = vsnprintf(buf->data + buf->len, buf->cap - buf->len, fmt, args);
+		va_end(args);
+		if (n >= 0 && buf->len + n < buf->cap)
+			break;
+		buf->cap = (buf->cap + n + 1) * 2;
+		buf->data = (char *)realloc(buf->data, buf->cap);
+		if (buf->data == NULL)
+		{
+			fprintf(stderr, "Out of memory generating the corpus.\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	buf->len += n;
+}
+
+static unsigned int bench_seed;
+
+static unsigned int bench_rand(void)
+{
+	//xorshift32, so every run generates the same documents
+	bench_seed ^= bench_seed << 13;
+	bench_seed ^= bench_seed >> 17;
+	bench_seed ^= bench_seed << 5;
+	return bench_seed;
+}
+
+static const char * bench_words[] = {
+	"request", "served", "cache", "miss", "upstream", "timeout", "user", "session",
+	"token", "refreshed", "latency", "ms", "retry", "queue", "worker", "started",
+	"finished", "payload", "accepted", "rejected", "database", "connection", "pool", "idle"
+};
+
+typedef struct bench_corpus_struct
+{
+	const char * name;
+	bench_buf doc;
+	bench_buf path; /* path used by the tree_get benchmarks */
+	bench_buf container; /* path to the main array/object, "" for the root */
+	int ndjson;
+} bench_corpus;
+
+static void bench_gen_wide(bench_corpus * corpus, size_t size, unsigned int depth)
+{
+	//One flat object with many keys of mixed types
+	unsigned int k;
+	(void)depth;
+	bench_buf_printf(&corpus->doc, "{");
+	for (k = 0; corpus->doc.len < size; k++)
+	{
+		bench_buf_printf(&corpus->doc, "%s\"key%06u\":", k ? "," : "", k);
+		switch (k % 5)
+		{
+		case 0: bench_buf_printf(&corpus->doc, "%u", bench_rand() % 1000000); break;
+		case 1: bench_buf_printf(&corpus->doc, "%d.%03u", (int)(bench_rand() % 2000) - 1000, bench_rand() % 1000); break;
+		case 2: bench_buf_printf(&corpus->doc, "\"value %u\"", bench_rand()); break;
+		case 3: bench_buf_printf(&corpus->doc, "%s", (bench_rand() & 1) ? "true" : "false"); break;
+		case 4: bench_buf_printf(&corpus->doc, "null"); break;
+		}
+	}
+	bench_buf_printf(&corpus->doc, "}");
+	bench_buf_printf(&corpus->path, "key%06u", k / 2);
+	bench_buf_printf(&corpus->container, "");
+}
+
+static void bench_gen_deep(bench_corpus * corpus, size_t size, unsigned int depth)
+{
+	//'depth' nested objects, each with a sibling before the way down
+	unsigned int d;
+	(void)size;
+	for (d = 0; d < depth; d++)
+	{
+		bench_buf_printf(&corpus->doc, "{\"n\":%u,\"a\":", d);
+		bench_buf_printf(&corpus->path, "%sa", d ? "\\" : "");
+	}
+	bench_buf_printf(&corpus->doc, "1");
+	for (d = 0; d < depth; d++)
+		bench_buf_printf(&corpus->doc, "}");
+	bench_buf_printf(&corpus->container, "");
+}
+
+static void bench_gen_numbers(bench_corpus * corpus, size_t size, unsigned int depth)
+{
+	//One long array of integers and decimals
+	unsigned int k;
+	(void)depth;
+	bench_buf_printf(&corpus->doc, "{\"values\":[");
+	for (k = 0; corpus->doc.len < size; k++)
+	{
+		if (k % 2)
+			bench_buf_printf(&corpus->doc, "%s%d", k ? "," : "", (int)(bench_rand() % 2000000) - 1000000);
+		else
+			bench_buf_printf(&corpus->doc, "%s%d.%04u", k ? "," : "", (int)(bench_rand() % 20000) - 10000, bench_rand() % 10000);
+	}
+	bench_buf_printf(&corpus->doc, "]}");
+	bench_buf_printf(&corpus->path, "values\\%u", k / 2);
+	bench_buf_printf(&corpus->container, "values");
+}
+
+static void bench_gen_logs(bench_corpus * corpus, size_t size, unsigned int depth)
+{
+	//Array of log records, mostly plain text
+	static const char * levels[] = { "info", "warn", "error", "debug" };
+	unsigned int k;
+	unsigned int w;
+	unsigned int words;
+	(void)depth;
+	bench_buf_printf(&corpus->doc, "{\"entries\":[");
+	for (k = 0; corpus->doc.len < size; k++)
+	{
+		bench_buf_printf(&corpus->doc, "%s{\"ts\":%u,\"level\":\"%s\",\"host\":\"web-%02u\",\"msg\":\"", k ? "," : "",
+			1690000000u + k, levels[bench_rand() % 4], bench_rand() % 32);
+		words = 6 + bench_rand() % 14;
+		for (w = 0; w < words; w++)
+			bench_buf_printf(&corpus->doc, "%s%s", w ? " " : "", bench_words[bench_rand() % (sizeof(bench_words) / sizeof(bench_words[0]))]);
+		bench_buf_printf(&corpus->doc, "\"}");
+	}
+	bench_buf_printf(&corpus->doc, "]}");
+	bench_buf_printf(&corpus->path, "entries\\%u\\msg", k / 2);
+	bench_buf_printf(&corpus->container, "entries");
+}
+
+static void bench_gen_escapes(bench_corpus * corpus, size_t size, unsigned int depth)
+{
+	//Array of strings where escapes are common
+	static const char * pieces[] = { "\\\"quoted\\\"", "C:\\\\path\\\\to\\\\file", "line\\nbreak", "caf\\u00e9", "tab\\there", "slash\\/ed", "plain" };
+	unsigned int k;
+	unsigned int w;
+	(void)depth;
+	bench_buf_printf(&corpus->doc, "{\"entries\":[");
+	for (k = 0; corpus->doc.len < size; k++)
+	{
+		bench_buf_printf(&corpus->doc, "%s{\"id\":%u,\"text\":\"", k ? "," : "", k);
+		for (w = 0; w < 8; w++)
+			bench_buf_printf(&corpus->doc, "%s%s", w ? " " : "", pieces[bench_rand() % (sizeof(pieces) / sizeof(pieces[0]))]);
+		bench_buf_printf(&corpus->doc, "\"}");
+	}
+	bench_buf_printf(&corpus->doc, "]}");
+	bench_buf_printf(&corpus->path, "entries\\%u\\text", k / 2);
+	bench_buf_printf(&corpus->container, "entries");
+}
+
+static void bench_gen_unicode(bench_corpus * corpus, size_t size, unsigned int depth)
+{
+	//Array of messages in several scripts, so most string bytes are multi-byte UTF-8
+	static const char * pieces[] = { "caf\xc3\xa9", "na\xc3\xafve", "\xce\xb1\xce\xbb\xcf\x86\xce\xb1", "\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82",
+		"\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e", "\xed\x95\x9c\xea\xb5\xad\xec\x96\xb4", "\xf0\x9f\x98\x80", "plain", "text" };
+	unsigned int k;
+	unsigned int w;
+	(void)depth;
+	bench_buf_printf(&corpus->doc, "{\"entries\":[");
+	for (k = 0; corpus->doc.len < size; k++)
+	{
+		bench_buf_printf(&corpus->doc, "%s{\"id\":%u,\"text\":\"", k ? "," : "", k);
+		for (w = 0; w < 8; w++)
+			bench_buf_printf(&corpus->doc, "%s%s", w ? " " : "", pieces[bench_rand() % (sizeof(pieces) / sizeof(pieces[0]))]);
+		bench_buf_printf(&corpus->doc, "\"}");
+	}
+	bench_buf_printf(&corpus->doc, "]}");
+	bench_buf_printf(&corpus->path, "entries\\%u\\text", k / 2);
+	bench_buf_printf(&corpus->container, "entries");
+}
+
+static void bench_gen_ndjson(bench_corpus * corpus, size_t size, unsigned int depth)
+{
+	//Many small documents, one per line
+	unsigned int k;
+	(void)depth;
+	for (k = 0; corpus->doc.len < size; k++)
+	{
+		bench_buf_printf(&corpus->doc, "{\"id\":%u,\"user\":{\"name\":\"user%u\",\"tags\":[\"a\",\"b\"]},\"score\":%u.%02u,\"active\":%s}\n",
+			k, bench_rand() % 100000, bench_rand() % 100, bench_rand() % 100, (bench_rand() & 1) ? "true" : "false");
+	}
+	bench_buf_printf(&corpus->path, "user\\name");
+	bench_buf_printf(&corpus->container, "");
+	corpus->ndjson = 1;
+}
+
+typedef struct bench_generator_struct
+{
+	const char * name;
+	void (*gen)(bench_corpus * corpus, size_t size, unsigned int depth);
+} bench_generator;
+
+static const bench_generator bench_generators[] = {
+	{ "wide", bench_gen_wide },
+	{ "deep", bench_gen_deep },
+	{ "numbers", bench_gen_numbers },
+	{ "logs", bench_gen_logs },
+	{ "escapes", bench_gen_escapes },
+	{ "unicode", bench_gen_unicode },
+	{ "ndjson", bench_gen_ndjson }
+};
+
+/* ---- HARNESS ---- */
+
+typedef struct bench_ctx_struct
+{
+	bench_corpus * corpus;
+	jsmnreader_obj reader;
+	jsmntok_t * tokens;
+	unsigned int tokens_count;
+	unsigned int container;
+	unsigned int * strings;
+	unsigned int strings_count;
+	unsigned long strings_bytes;
+	char repeat_paths[32][128]; /* paths to items spread over the main array/object */
+	unsigned int repeat_count;
+	jsmnreader_column columns[8]; /* the keys of the main array's first object, when it holds objects */
+	char column_keys[8][32];
+	unsigned int columns_count;
+	unsigned int rows;
+	char * arena;
+	unsigned int arena_size;
+	double * numbers; /* room for every token, which the main array can't have more items than */
+#ifdef JSMNR_BATCH
+	jsmnreader_batch batch;
+	char ** batch_docs; /* NDJSON lines */
+	unsigned int * batch_sizes;
+	unsigned int batch_count;
+#endif
+	unsigned long sink;
+} bench_ctx;
+
+typedef void (*bench_fn)(bench_ctx * ctx);
+
+static double bench_min_time;
+static const char * bench_only;
+static unsigned int bench_threads;
+
+static double bench_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static const char * bench_build(void)
+{
+	//Which optional features this binary was built with
+	return ""
+#ifdef JSMNR_ARRAY_INDEX
+		" JSMNR_ARRAY_INDEX"
+#endif
+#ifdef JSMNR_STATS
+		" JSMNR_STATS"
+#endif
+#ifdef JSMNR_TRACE
+		" JSMNR_TRACE"
+#endif
+#ifdef JSMNR_UTF8_VALIDATE
+		" JSMNR_UTF8_VALIDATE"
+#endif
+#ifdef JSMNR_SIDECAR
+		" JSMNR_SIDECAR"
+#endif
+#ifdef JSMNR_SIDECAR_HASH
+		" JSMNR_SIDECAR_HASH"
+#endif
+#ifdef JSMNR_CACHE
+		" JSMNR_CACHE"
+#endif
+#ifdef JSMNR_PATH_CACHE
+		" JSMNR_PATH_CACHE"
+#endif
+#ifdef JSMNR_BATCH
+		" JSMNR_BATCH"
+#endif
+#ifdef JSMNR_AVX2
+		" JSMNR_AVX2"
+#elif defined(JSMNR_SSE2)
+		" JSMNR_SSE2"
+#endif
+		;
+}
+
+static void bench_run(bench_ctx * ctx, const char * name, bench_fn fn, double bytes_per_iter, double ops_per_iter)
+{
+	unsigned long iters;
+	unsigned long i;
+	unsigned long allocs;
+	double start;
+	double elapsed;
+	const char * build;
+	if (bench_only != NULL && strcmp(bench_only, name) != 0)
+		return;
+	fn(ctx); //warm up
+	iters = 1;
+	for (;;)
+	{
+		allocs = bench_allocs;
+		start = bench_now();
+		for (i = 0; i < iters; i++)
+			fn(ctx);
+		elapsed = bench_now() - start;
+		allocs = bench_allocs - allocs;
+		if (elapsed >= bench_min_time || iters >= (1ul << 30))
+			break;
+		iters *= (elapsed > 0 && bench_min_time / elapsed < 100) ? 2 : 16;
+	}
+	build = bench_build();
+	printf("{\"corpus\":\"%s\",\"bench\":\"%s\",\"build\":\"%s\",\"bytes\":%lu,\"iters\":%lu,\"ops\":%.0f,\"ns_per_op\":%.2f,\"mb_per_s\":%.2f,\"allocs_per_op\":%.3f}\n",
+		ctx->corpus->name, name, *build ? build + 1 : "", (unsigned long)ctx->corpus->doc.len, iters, ops_per_iter,
+		elapsed * 1e9 / (iters * ops_per_iter),
+		bytes_per_iter > 0 ? bytes_per_iter * iters / elapsed / 1e6 : 0.0,
+		(double)allocs / (iters * ops_per_iter));
+	fflush(stdout);
+}
+
+static void bench_load(bench_ctx * ctx, char * str, unsigned int len)
+{
+	//The corpus buffer belongs to the benchmark, so the reader only borrows it
+	if (jsmnreader_load_mode(str, len, JSMNR_LOAD_BORROW, &ctx->reader) != JSMN_SUCCESS)
+	{
+		fprintf(stderr, "%s: failed to load the corpus.\n", ctx->corpus->name);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/* Whole document benchmarks */
+
+static void bench_fn_parse(bench_ctx * ctx)
+{
+	jsmn_parser parser;
+	jsmn_init(&parser);
+	ctx->sink += jsmn_parse(&parser, ctx->corpus->doc.data, ctx->corpus->doc.len, ctx->tokens, ctx->tokens_count, 0);
+}
+
+static void bench_fn_validate(bench_ctx * ctx)
+{
+	ctx->sink += jsmnreader_validate(ctx->corpus->doc.data, ctx->corpus->doc.len, NULL);
+}
+
+static void bench_fn_utf8_validate(bench_ctx * ctx)
+{
+	ctx->sink += jsmnreader_utf8_validate(ctx->corpus->doc.data, ctx->corpus->doc.len, NULL);
+}
+
+static void bench_fn_load(bench_ctx * ctx)
+{
+	bench_load(ctx, ctx->corpus->doc.data, ctx->corpus->doc.len);
+	ctx->sink += ctx->reader.tokens_count;
+}
+
+static void bench_fn_load_cold(bench_ctx * ctx)
+{
+	//A new reader every time, so the tokens are sized from nothing like on a first load
+	jsmnreader_obj reader;
+	jsmnreader_init(&reader);
+	if (jsmnreader_load_mode(ctx->corpus->doc.data, ctx->corpus->doc.len, JSMNR_LOAD_BORROW, &reader) != JSMN_SUCCESS)
+		exit(EXIT_FAILURE);
+	ctx->sink += reader.tokens_count;
+	jsmnreader_free(&reader);
+}
+
+#if defined(JSMNR_SIDECAR) || defined(JSMNR_CACHE)
+#define BENCH_FILE "bench_corpus.json"
+
+static void bench_fn_fileload(bench_ctx * ctx)
+{
+	if (jsmnreader_fileload(BENCH_FILE, &ctx->reader) != JSMN_SUCCESS)
+		exit(EXIT_FAILURE);
+	ctx->sink += ctx->reader.tokens_count;
+}
+
+#ifdef JSMNR_SIDECAR
+static void bench_fn_fileload_sidecar(bench_ctx * ctx)
+{
+	//The warm up call writes the index, every timed one maps it back in
+	if (jsmnreader_fileload_sidecar(BENCH_FILE, NULL, &ctx->reader) != JSMN_SUCCESS)
+		exit(EXIT_FAILURE);
+	ctx->sink += ctx->reader.tokens_count;
+}
+#endif
+
+#ifdef JSMNR_CACHE
+static void bench_fn_cache_fileload(bench_ctx * ctx)
+{
+	//The warm up call loads the file, every timed one is a hit
+	jsmnreader_obj * reader;
+	reader = jsmnreader_cache_fileload(BENCH_FILE, NULL);
+	if (reader == NULL)
+		exit(EXIT_FAILURE);
+	ctx->sink += reader->tokens_count;
+	jsmnreader_cache_release(reader);
+}
+#endif
+
+static void bench_files_run(bench_ctx * ctx)
+{
+	FILE * file;
+	file = fopen(BENCH_FILE, "wb");
+	if (file == NULL || fwrite(ctx->corpus->doc.data, 1, ctx->corpus->doc.len, file) != ctx->corpus->doc.len || fclose(file) != 0)
+	{
+		fprintf(stderr, "%s: failed to write %s.\n", ctx->corpus->name, BENCH_FILE);
+		exit(EXIT_FAILURE);
+	}
+	bench_run(ctx, "fileload", bench_fn_fileload, ctx->corpus->doc.len, 1);
+#ifdef JSMNR_SIDECAR
+	remove(BENCH_FILE ".jsmnr");
+	bench_run(ctx, "fileload_sidecar", bench_fn_fileload_sidecar, ctx->corpus->doc.len, 1);
+	jsmnreader_reset(&ctx->reader);
+#endif
+#ifdef JSMNR_CACHE
+	bench_run(ctx, "cache_fileload", bench_fn_cache_fileload, ctx->corpus->doc.len, 1);
+	jsmnreader_cache_clear(); //each corpus rewrites the file, maybe within the same second
+#endif
+	remove(BENCH_FILE);
+	remove(BENCH_FILE ".jsmnr");
+}
+#endif
+
+static void bench_fn_tree_get_x(bench_ctx * ctx)
+{
+	ctx->sink += jsmnreader_tree_get_x(ctx->corpus->path.data, 0, &ctx->reader);
+}
+
+static void bench_fn_tree_get_repeat(bench_ctx * ctx)
+{
+	//The same handful of paths over and over, like a template filled in from one document
+	unsigned int i;
+	for (i = 0; i < ctx->repeat_count; i++)
+		ctx->sink += jsmnreader_tree_get_x(ctx->repeat_paths[i], 0, &ctx->reader);
+}
+
+static void bench_fn_tree_get_string(bench_ctx * ctx)
+{
+	char * txt;
+	txt = jsmnreader_tree_get_string(ctx->corpus->path.data, 0, &ctx->reader);
+	ctx->sink += txt[0];
+	free(txt);
+}
+
+static void bench_fn_tree_get_float(bench_ctx * ctx)
+{
+	ctx->sink += (unsigned long)jsmnreader_tree_get_float(ctx->corpus->path.data, 0, &ctx->reader);
+}
+
+static void bench_fn_token_array(bench_ctx * ctx)
+{
+	//Indexed access in the middle of the array
+	ctx->sink += jsmnreader_token_array(jsmnreader_token_size(ctx->container, &ctx->reader) / 2, ctx->container, &ctx->reader);
+}
+
+static void bench_fn_token_array_tokens(bench_ctx * ctx)
+{
+	unsigned int * arrays;
+	unsigned int arrays_size;
+	jsmnreader_token_array_tokens(&arrays, &arrays_size, ctx->container, &ctx->reader);
+	ctx->sink += arrays_size;
+	free(arrays);
+}
+
+static void bench_fn_token_object_tokens(bench_ctx * ctx)
+{
+	unsigned int * arrays;
+	unsigned int arrays_size;
+	jsmnreader_token_object_tokens(&arrays, &arrays_size, ctx->container, JSMNR_BOTH, &ctx->reader);
+	ctx->sink += arrays_size;
+	free(arrays);
+}
+
+static void bench_fn_iter(bench_ctx * ctx)
+{
+	jsmnreader_iter iter;
+	unsigned int item;
+	jsmnreader_iter_init(&iter, ctx->container, &ctx->reader);
+	while ((item = jsmnreader_iter_next(&iter, &ctx->reader)) != (unsigned int)-1)
+		ctx->sink += item;
+}
+
+static void bench_fn_token_get_string(bench_ctx * ctx)
+{
+	unsigned int i;
+	char * txt;
+	for (i = 0; i < ctx->strings_count; i++)
+	{
+		txt = jsmnreader_token_get_string(*(ctx->strings + i), &ctx->reader);
+		ctx->sink += txt[0];
+		free(txt);
+	}
+}
+
+static void bench_fn_token_copy_string(bench_ctx * ctx)
+{
+	unsigned int i;
+	char txt[256];
+	for (i = 0; i < ctx->strings_count; i++)
+	{
+		jsmnreader_token_copy_string(*(ctx->strings + i), txt, sizeof(txt), &ctx->reader);
+		ctx->sink += txt[0];
+	}
+}
+
+static void bench_fn_token_get_float(bench_ctx * ctx)
+{
+	jsmnreader_iter iter;
+	unsigned int item;
+	jsmnreader_iter_init(&iter, ctx->container, &ctx->reader);
+	while ((item = jsmnreader_iter_next(&iter, &ctx->reader)) != (unsigned int)-1)
+		ctx->sink += (unsigned long)jsmnreader_token_get_float(item, &ctx->reader);
+}
+
+static void bench_fn_token_array_get_float(bench_ctx * ctx)
+{
+	unsigned int error_index;
+	ctx->sink += jsmnreader_token_array_get_float((float *)ctx->numbers, ctx->reader.tokens_count, &error_index, ctx->container, &ctx->reader);
+}
+
+static void bench_fn_token_array_get_double(bench_ctx * ctx)
+{
+	unsigned int error_index;
+	ctx->sink += jsmnreader_token_array_get_double(ctx->numbers, ctx->reader.tokens_count, &error_index, ctx->container, &ctx->reader);
+}
+
+static void bench_fn_token_array_get_int64(bench_ctx * ctx)
+{
+	unsigned int error_index;
+	ctx->sink += jsmnreader_token_array_get_int64((long long *)ctx->numbers, ctx->reader.tokens_count, &error_index, ctx->container, &ctx->reader);
+}
+
+static void bench_fn_columns_per_field(bench_ctx * ctx)
+{
+	//Every field of every record looked up on its own, as without jsmnreader_token_array_columns()
+	jsmnreader_iter iter;
+	unsigned int item;
+	unsigned int c;
+	char buffer[256];
+	jsmnreader_iter_init(&iter, ctx->container, &ctx->reader);
+	while ((item = jsmnreader_iter_next(&iter, &ctx->reader)) != (unsigned int)-1)
+	{
+		for (c = 0; c < ctx->columns_count; c++)
+		{
+			if (ctx->columns[c].type == JSMNR_COLUMN_INT64)
+				ctx->sink += jsmnreader_tree_get_int(ctx->column_keys[c], item, &ctx->reader);
+			else if (ctx->columns[c].type == JSMNR_COLUMN_DOUBLE)
+				ctx->sink += (unsigned long)jsmnreader_tree_get_float(ctx->column_keys[c], item, &ctx->reader);
+			else
+				ctx->sink += jsmnreader_tree_copy_string(ctx->column_keys[c], item, buffer, sizeof(buffer), &ctx->reader);
+		}
+	}
+}
+
+static void bench_fn_token_array_columns(bench_ctx * ctx)
+{
+	unsigned int used;
+	ctx->sink += jsmnreader_token_array_columns(ctx->columns, ctx->columns_count, ctx->rows, ctx->arena, ctx->arena_size, &used, ctx->container, &ctx->reader);
+	ctx->sink += used;
+}
+
+static void bench_columns(bench_ctx * ctx)
+{
+	//A column per key of the first record, typed by its value there
+	jsmnreader_iter iter;
+	unsigned int first;
+	unsigned int value;
+	unsigned int i;
+	ctx->columns_count = 0;
+	ctx->rows = jsmnreader_token_size(ctx->container, &ctx->reader);
+	first = jsmnreader_token_array(0, ctx->container, &ctx->reader);
+	if (first == (unsigned int)-1 || (ctx->reader.tokens + first)->type != JSMN_OBJECT)
+		return;
+	jsmnreader_iter_init(&iter, first, &ctx->reader);
+	while ((value = jsmnreader_iter_next(&iter, &ctx->reader)) != (unsigned int)-1 && ctx->columns_count < 8)
+	{
+		i = ctx->columns_count;
+		if (jsmnreader_token_copy_string(iter.key, ctx->column_keys[i], sizeof(ctx->column_keys[0]), &ctx->reader) >= (int)sizeof(ctx->column_keys[0]))
+			continue;
+		ctx->columns[i].key = ctx->column_keys[i];
+		if (jsmnreader_token_subtype(value, &ctx->reader) & JSMN_PRIMITIVE_INT)
+			ctx->columns[i].type = JSMNR_COLUMN_INT64;
+		else if (jsmnreader_token_subtype(value, &ctx->reader) & JSMN_PRIMITIVE_FLOAT)
+			ctx->columns[i].type = JSMNR_COLUMN_DOUBLE;
+		else
+			ctx->columns[i].type = JSMNR_COLUMN_STRING;
+		ctx->columns[i].values = malloc((size_t)ctx->rows * sizeof(double));
+		ctx->columns[i].found = NULL;
+		ctx->columns_count++;
+	}
+	//The strings can't take more room than the document
+	ctx->arena_size = ctx->corpus->doc.len;
+	ctx->arena = (char *)malloc(ctx->arena_size);
+}
+
+static void bench_fn_load_strings(bench_ctx * ctx)
+{
+	//Reading every string after a load, against the same with jsmnreader_insitu() below
+	bench_load(ctx, ctx->corpus->doc.data, ctx->corpus->doc.len);
+	bench_fn_token_get_string(ctx);
+}
+
+static void bench_fn_insitu_strings(bench_ctx * ctx)
+{
+	unsigned int i;
+	//The corpus is copied in, since jsmnreader_insitu() writes over the JSON string
+	if (jsmnreader_load_mode(ctx->corpus->doc.data, ctx->corpus->doc.len, JSMNR_LOAD_COPY, &ctx->reader) != JSMN_SUCCESS)
+		exit(EXIT_FAILURE);
+	jsmnreader_insitu(&ctx->reader);
+	for (i = 0; i < ctx->strings_count; i++)
+		ctx->sink += jsmnreader_token_get_insitu(*(ctx->strings + i), &ctx->reader)[0];
+}
+
+/* NDJSON benchmarks, one document per line */
+
+static void bench_fn_ndjson_load(bench_ctx * ctx)
+{
+	char * line;
+	char * end;
+	char * stop;
+	line = ctx->corpus->doc.data;
+	stop = line + ctx->corpus->doc.len;
+	while (line < stop)
+	{
+		end = (char *)memchr(line, '\n', stop - line);
+		if (end == NULL)
+			end = stop;
+		bench_load(ctx, line, end - line);
+		ctx->sink += ctx->reader.tokens_count;
+		line = end + 1;
+	}
+}
+
+static void bench_fn_ndjson_load_cold(bench_ctx * ctx)
+{
+	char * line;
+	char * end;
+	char * stop;
+	jsmnreader_obj reader;
+	line = ctx->corpus->doc.data;
+	stop = line + ctx->corpus->doc.len;
+	while (line < stop)
+	{
+		end = (char *)memchr(line, '\n', stop - line);
+		if (end == NULL)
+			end = stop;
+		jsmnreader_init(&reader);
+		if (jsmnreader_load_mode(line, end - line, JSMNR_LOAD_BORROW, &reader) != JSMN_SUCCESS)
+			exit(EXIT_FAILURE);
+		ctx->sink += reader.tokens_count;
+		jsmnreader_free(&reader);
+		line = end + 1;
+	}
+}
+
+static void bench_fn_ndjson_validate(bench_ctx * ctx)
+{
+	char * line;
+	char * end;
+	char * stop;
+	line = ctx->corpus->doc.data;
+	stop = line + ctx->corpus->doc.len;
+	while (line < stop)
+	{
+		end = (char *)memchr(line, '\n', stop - line);
+		if (end == NULL)
+			end = stop;
+		ctx->sink += jsmnreader_validate(line, end - line, NULL);
+		line = end + 1;
+	}
+}
+
+static void bench_fn_ndjson_query(bench_ctx * ctx)
+{
+	char * line;
+	char * end;
+	char * stop;
+	char * txt;
+	line = ctx->corpus->doc.data;
+	stop = line + ctx->corpus->doc.len;
+	while (line < stop)
+	{
+		end = (char *)memchr(line, '\n', stop - line);
+		if (end == NULL)
+			end = stop;
+		bench_load(ctx, line, end - line);
+		txt = jsmnreader_tree_get_string(ctx->corpus->path.data, 0, &ctx->reader);
+		ctx->sink += txt[0] + jsmnreader_tree_get_int("id", 0, &ctx->reader);
+		free(txt);
+		line = end + 1;
+	}
+}
+
+#ifdef JSMNR_BATCH
+/* Batch benchmarks, the NDJSON lines shared out between threads */
+
+static void bench_fn_batch(bench_ctx * ctx)
+{
+	ctx->sink += jsmnreader_batch_run(ctx->batch_docs, ctx->batch_sizes, ctx->batch_count, NULL, &ctx->batch);
+}
+
+static void bench_batch(bench_ctx * ctx, const char * name, unsigned int threads, unsigned int lines)
+{
+	//The fields load_query reads, and two more
+	char * paths[4] = { "id", "user\\name", "score", "active" };
+	jsmnreaderbatch_t types[4] = { JSMNR_BATCH_INT, JSMNR_BATCH_STRING, JSMNR_BATCH_FLOAT, JSMNR_BATCH_INT };
+	jsmnreader_batch_column columns[4];
+	char * line;
+	char * end;
+	char * stop;
+	unsigned int i;
+	ctx->batch_docs = (char **)malloc(lines * sizeof(char *));
+	ctx->batch_sizes = (unsigned int *)malloc(lines * sizeof(unsigned int));
+	ctx->batch_count = 0;
+	line = ctx->corpus->doc.data;
+	stop = line + ctx->corpus->doc.len;
+	while (line < stop && ctx->batch_count < lines)
+	{
+		end = (char *)memchr(line, '\n', stop - line);
+		if (end == NULL)
+			end = stop;
+		*(ctx->batch_docs + ctx->batch_count) = line;
+		*(ctx->batch_sizes + ctx->batch_count) = end - line;
+		ctx->batch_count++;
+		line = end + 1;
+	}
+	for (i = 0; i < 4; i++)
+	{
+		columns[i].path = paths[i];
+		columns[i].type = types[i];
+		columns[i].string_size = (types[i] == JSMNR_BATCH_STRING) ? 16 : 0;
+		columns[i].values = malloc((size_t)lines * ((columns[i].string_size > 0) ? columns[i].string_size : sizeof(double)));
+		columns[i].found = NULL;
+	}
+	if (jsmnreader_batch_init(columns, 4, threads, &ctx->batch) != JSMN_SUCCESS)
+		exit(EXIT_FAILURE);
+	bench_run(ctx, name, bench_fn_batch, ctx->corpus->doc.len, ctx->batch_count);
+	jsmnreader_batch_free(&ctx->batch);
+	for (i = 0; i < 4; i++)
+		free(columns[i].values);
+	free(ctx->batch_docs);
+	free(ctx->batch_sizes);
+}
+#endif
+
+/* Multi-threaded benchmarks, over one frozen reader */
+
+#define BENCH_MT_ROUNDS 64
+
+typedef struct bench_thread_struct
+{
+	bench_ctx * ctx;
+	pthread_t thread;
+	unsigned long sink;
+} bench_thread;
+
+static void * bench_query_thread(void * arg)
+{
+	//Path lookups, and indexed access when the main container is an array
+	bench_thread * t;
+	bench_ctx * ctx;
+	unsigned int round;
+	unsigned int i;
+	unsigned int size;
+	t = (bench_thread *)arg;
+	ctx = t->ctx;
+	size = jsmnreader_token_size(ctx->container, &ctx->reader);
+	for (round = 0; round < BENCH_MT_ROUNDS; round++)
+	{
+		for (i = 0; i < ctx->repeat_count; i++)
+		{
+			t->sink += jsmnreader_tree_get_x(ctx->repeat_paths[i], 0, &ctx->reader);
+			if ((ctx->reader.tokens + ctx->container)->type == JSMN_ARRAY)
+				t->sink += jsmnreader_token_array((round * 31 + i * 7) % size, ctx->container, &ctx->reader);
+		}
+	}
+	return NULL;
+}
+
+static void bench_fn_query_mt(bench_ctx * ctx)
+{
+	bench_thread threads[64];
+	unsigned int i;
+	for (i = 0; i < bench_threads; i++)
+	{
+		threads[i].ctx = ctx;
+		threads[i].sink = 0;
+		if (pthread_create(&threads[i].thread, NULL, bench_query_thread, &threads[i]) != 0)
+			exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < bench_threads; i++)
+	{
+		pthread_join(threads[i].thread, NULL);
+		ctx->sink += threads[i].sink;
+	}
+}
+
+static void bench_repeat_paths(bench_ctx * ctx)
+{
+	jsmnreader_iter iter;
+	unsigned int item;
+	unsigned int i;
+	unsigned int size;
+	char key[64];
+	size = jsmnreader_token_size(ctx->container, &ctx->reader);
+	jsmnreader_iter_init(&iter, ctx->container, &ctx->reader);
+	for (i = 0; (item = jsmnreader_iter_next(&iter, &ctx->reader)) != (unsigned int)-1 && ctx->repeat_count < 32; i++)
+	{
+		if (i % (size / 32 + 1) != 0)
+			continue;
+		if (iter.key != (unsigned int)-1)
+			jsmnreader_token_copy_string(iter.key, key, sizeof(key), &ctx->reader);
+		else
+			sprintf(key, "%u", i);
+		snprintf(ctx->repeat_paths[ctx->repeat_count], sizeof(ctx->repeat_paths[0]), "%s%s%s",
+			ctx->corpus->container.len > 0 ? ctx->corpus->container.data : "", ctx->corpus->container.len > 0 ? "\\" : "", key);
+		ctx->repeat_count++;
+	}
+}
+
+static void bench_corpus_run(bench_corpus * corpus)
+{
+	bench_ctx ctx;
+	jsmn_parser parser;
+	unsigned int i;
+	unsigned int lines;
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.corpus = corpus;
+	jsmnreader_init(&ctx.reader);
+
+	if (corpus->ndjson)
+	{
+		lines = 0;
+		for (i = 0; i < corpus->doc.len; i++)
+			if (corpus->doc.data[i] == '\n')
+				lines++;
+		bench_run(&ctx, "validate", bench_fn_ndjson_validate, corpus->doc.len, lines);
+		bench_run(&ctx, "load", bench_fn_ndjson_load, corpus->doc.len, lines);
+		bench_run(&ctx, "load_cold", bench_fn_ndjson_load_cold, corpus->doc.len, lines);
+		bench_run(&ctx, "load_query", bench_fn_ndjson_query, corpus->doc.len, lines);
+#ifdef JSMNR_BATCH
+		bench_batch(&ctx, "batch_1t", 1, lines);
+		bench_batch(&ctx, "batch", bench_threads, lines);
+#endif
+	}
+	else
+	{
+		jsmn_init(&parser);
+		ctx.tokens_count = jsmn_parse(&parser, corpus->doc.data, corpus->doc.len, NULL, 0, 1);
+		ctx.tokens = (jsmntok_t *)malloc(ctx.tokens_count * sizeof(jsmntok_t));
+		bench_run(&ctx, "parse", bench_fn_parse, corpus->doc.len, 1);
+		bench_run(&ctx, "validate", bench_fn_validate, corpus->doc.len, 1);
+		bench_run(&ctx, "utf8_validate", bench_fn_utf8_validate, corpus->doc.len, 1);
+		bench_run(&ctx, "load", bench_fn_load, corpus->doc.len, 1);
+		bench_run(&ctx, "load_cold", bench_fn_load_cold, corpus->doc.len, 1);
+#if defined(JSMNR_SIDECAR) || defined(JSMNR_CACHE)
+		bench_files_run(&ctx);
+#endif
+
+		bench_load(&ctx, corpus->doc.data, corpus->doc.len);
+		ctx.container = 0;
+		if (corpus->container.len > 0)
+			ctx.container = jsmnreader_tree_get_x(corpus->container.data, 0, &ctx.reader);
+		ctx.strings = (unsigned int *)malloc(ctx.reader.tokens_count * sizeof(unsigned int));
+		for (i = 0; i < ctx.reader.tokens_count; i++)
+		{
+			if ((ctx.reader.tokens + i)->type == JSMN_STRING)
+			{
+				*(ctx.strings + ctx.strings_count) = i;
+				ctx.strings_count++;
+				ctx.strings_bytes += (ctx.reader.tokens + i)->end - (ctx.reader.tokens + i)->start;
+			}
+		}
+
+		bench_run(&ctx, "tree_get_x", bench_fn_tree_get_x, 0, 1);
+		bench_repeat_paths(&ctx);
+		if (ctx.repeat_count > 0)
+			bench_run(&ctx, "tree_get_repeat", bench_fn_tree_get_repeat, 0, ctx.repeat_count);
+		if ((ctx.reader.tokens + jsmnreader_tree_get_x(corpus->path.data, 0, &ctx.reader))->type == JSMN_STRING)
+			bench_run(&ctx, "tree_get_string", bench_fn_tree_get_string, 0, 1);
+		else
+			bench_run(&ctx, "tree_get_float", bench_fn_tree_get_float, 0, 1);
+		bench_run(&ctx, "iter", bench_fn_iter, 0, jsmnreader_token_size(ctx.container, &ctx.reader));
+		if ((ctx.reader.tokens + ctx.container)->type == JSMN_ARRAY)
+		{
+			bench_run(&ctx, "token_array", bench_fn_token_array, 0, 1);
+			bench_run(&ctx, "token_array_tokens", bench_fn_token_array_tokens, 0, 1);
+			bench_columns(&ctx);
+			if (ctx.columns_count > 0)
+			{
+				bench_run(&ctx, "columns_per_field", bench_fn_columns_per_field, 0, ctx.rows);
+				bench_run(&ctx, "token_array_columns", bench_fn_token_array_columns, 0, ctx.rows);
+				for (i = 0; i < ctx.columns_count; i++)
+					free(ctx.columns[i].values);
+				free(ctx.arena);
+			}
+		}
+		else
+		{
+			bench_run(&ctx, "token_object_tokens", bench_fn_token_object_tokens, 0, 1);
+		}
+		if (ctx.strings_count > 0)
+		{
+			bench_run(&ctx, "token_get_string", bench_fn_token_get_string, ctx.strings_bytes, ctx.strings_count);
+			bench_run(&ctx, "token_copy_string", bench_fn_token_copy_string, ctx.strings_bytes, ctx.strings_count);
+		}
+		if (strcmp(corpus->name, "numbers") == 0)
+		{
+			bench_run(&ctx, "token_get_float", bench_fn_token_get_float, 0, jsmnreader_token_size(ctx.container, &ctx.reader));
+			ctx.numbers = (double *)malloc(ctx.reader.tokens_count * sizeof(double));
+			bench_run(&ctx, "token_array_get_float", bench_fn_token_array_get_float, 0, jsmnreader_token_size(ctx.container, &ctx.reader));
+			bench_run(&ctx, "token_array_get_double", bench_fn_token_array_get_double, 0, jsmnreader_token_size(ctx.container, &ctx.reader));
+			bench_run(&ctx, "token_array_get_int64", bench_fn_token_array_get_int64, 0, jsmnreader_token_size(ctx.container, &ctx.reader));
+			free(ctx.numbers);
+		}
+		if (ctx.strings_count > 0)
+		{
+			bench_run(&ctx, "load_strings", bench_fn_load_strings, corpus->doc.len, 1);
+			bench_run(&ctx, "insitu_strings", bench_fn_insitu_strings, corpus->doc.len, 1);
+		}
+		if (ctx.repeat_count > 0)
+		{
+			//ns_per_op is wall time over the lookups of every thread, so it drops as threads are added
+			//Warm the path cache before freezing, since a frozen reader only probes it
+			bench_load(&ctx, corpus->doc.data, corpus->doc.len);
+			for (i = 0; i < ctx.repeat_count; i++)
+				ctx.sink += jsmnreader_tree_get_x(ctx.repeat_paths[i], 0, &ctx.reader);
+			jsmnreader_freeze(&ctx.reader);
+			bench_run(&ctx, "query_mt", bench_fn_query_mt, 0, (double)bench_threads * BENCH_MT_ROUNDS * ctx.repeat_count);
+		}
+		free(ctx.strings);
+		free(ctx.tokens);
+	}
+
+	jsmnreader_free(&ctx.reader);
+	if (ctx.sink == 1)
+		fprintf(stderr, "\n"); //keeps the results alive
+}
+
+static void bench_usage(const char * name)
+{
+	fprintf(stderr, "Usage: %s [-s bytes] [-d depth] [-t seconds] [-c corpus] [-b benchmark] [-j threads]\n", name);
+	fprintf(stderr, "  -s  approximate size of each generated corpus (default 1048576)\n");
+	fprintf(stderr, "  -d  nesting depth of the \"deep\" corpus (default 1000, at most JSMNR_MAX_DEPTH = %d)\n", JSMNR_MAX_DEPTH);
+	fprintf(stderr, "  -t  minimum time spent on each benchmark (default 0.5)\n");
+	fprintf(stderr, "  -c  only run this corpus (wide, deep, numbers, logs, escapes, unicode, ndjson)\n");
+	fprintf(stderr, "  -b  only run this benchmark\n");
+	fprintf(stderr, "  -j  threads for the query_mt and batch benchmarks (default: one per CPU, at most 64)\n");
+	fprintf(stderr, "Results are printed as one JSON object per line.\n");
+}
+
+int main(int argc, char ** argv)
+{
+	bench_corpus corpus;
+	size_t size;
+	unsigned int depth;
+	const char * only_corpus;
+	unsigned int g;
+	int i;
+
+	size = 1 << 20;
+	depth = 1000;
+	bench_min_time = 0.5;
+	only_corpus = NULL;
+	bench_only = NULL;
+	bench_threads = (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	for (i = 1; i < argc; i++)
+	{
+		if (i + 1 < argc && strcmp(argv[i], "-s") == 0)
+			size = strtoul(argv[++i], NULL, 10);
+		else if (i + 1 < argc && strcmp(argv[i], "-d") == 0)
+			depth = strtoul(argv[++i], NULL, 10);
+		else if (i + 1 < argc && strcmp(argv[i], "-t") == 0)
+			bench_min_time = strtod(argv[++i], NULL);
+		else if (i + 1 < argc && strcmp(argv[i], "-c") == 0)
+			only_corpus = argv[++i];
+		else if (i + 1 < argc && strcmp(argv[i], "-b") == 0)
+			bench_only = argv[++i];
+		else if (i + 1 < argc && strcmp(argv[i], "-j") == 0)
+			bench_threads = strtoul(argv[++i], NULL, 10);
+		else
+		{
+			bench_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (bench_threads < 1)
+		bench_threads = 1;
+	if (bench_threads > 64)
+		bench_threads = 64;
+	for (g = 0; g < sizeof(bench_generators) / sizeof(bench_generators[0]); g++)
+	{
+		if (only_corpus != NULL && strcmp(only_corpus, bench_generators[g].name) != 0)
+			continue;
+		memset(&corpus, 0, sizeof(corpus));
+		corpus.name = bench_generators[g].name;
+		bench_seed = 2463534242u;
+		bench_generators[g].gen(&corpus, size, depth);
+		bench_corpus_run(&corpus);
+		free(corpus.doc.data);
+		free(corpus.path.data);
+		free(corpus.container.data);
+	}
+	return EXIT_SUCCESS;
+}
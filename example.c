@@ -45,6 +45,7 @@ int main()
             case JSMN_ERROR_INVAL: printf("Invalid format.\n"); break;
             case JSMN_ERROR_PART: printf("Fragmented JSON.\n"); break;
             case JSMN_ERROR_NOFILE: printf("File not found.\n"); break;
+            case JSMN_ERROR_DEPTH: printf("Nested too deep.\n"); break;
         }
 		return EXIT_FAILURE;
     }
@@ -98,6 +99,7 @@ int main()
     printf("Array (examples): %u\n", jsmnreader_tree_get_array("examples", 0, &myjsmn));
 
     printf("Any, tree_get_x (repository\\sub\\reddit): %u\n", jsmnreader_tree_get_any("repository\\sub\\reddit", 0, &myjsmn));
+    printf("Any, tree_get_x (examples\\1\\base\\Speed): %u\n", jsmnreader_tree_get_any("examples\\1\\base\\Speed", 0, &myjsmn));
     printf("Any, tree_get_any (frameworks): %u\n", jsmnreader_tree_get_any("frameworks", 0, &myjsmn));
     printf("Any, tree_anyprint (examples): "); jsmnreader_tree_anyprint("examples", 0, &myjsmn);
 
@@ -32,6 +32,46 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stddef.h>
+#include <limits.h>
+#include <float.h>
+#if defined(JSMNR_STATS) || defined(JSMNR_TRACE)
+#include <time.h>
+#endif
+#if defined(JSMNR_SIDECAR) || defined(JSMNR_CACHE)
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+#ifdef JSMNR_SIDECAR
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if defined(JSMNR_CACHE) || defined(JSMNR_BATCH)
+#include <pthread.h>
+#endif
+#if defined(JSMNR_BATCH) && !defined(JSMNR_SIDECAR)
+#include <unistd.h>
+#endif
+#if defined(__SSE2__) && defined(__GNUC__) && !defined(JSMNR_NO_SIMD)
+#include <emmintrin.h>
+#define JSMNR_SSE2
+#endif
+#if defined(__SSSE3__) && defined(__GNUC__) && !defined(JSMNR_NO_SIMD)
+#include <tmmintrin.h>
+#define JSMNR_SSSE3
+#endif
+#if defined(__AVX2__) && defined(__GNUC__) && !defined(JSMNR_NO_SIMD)
+#include <immintrin.h>
+#define JSMNR_AVX2
+#endif
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && !defined(JSMNR_NO_SIMD)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define JSMNR_SWAR
+#endif
+#endif
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+#define JSMNR_ATOMICS
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -41,6 +81,45 @@ extern "C" {
 #define JSMN_API static
 #else
 #define JSMN_API extern
+#endif
+
+#if defined(JSMNR_NO_HEAP) && defined(JSMNR_ARRAY_INDEX)
+#error "JSMNR_ARRAY_INDEX builds its tables on the heap, so it can't be used with JSMNR_NO_HEAP"
+#endif
+#if defined(JSMNR_NO_HEAP) && defined(JSMNR_SIDECAR)
+#error "JSMNR_SIDECAR swaps the reader's tokens for mapped ones, so it can't be used with JSMNR_NO_HEAP"
+#endif
+#if defined(JSMNR_NO_HEAP) && defined(JSMNR_CACHE)
+#error "JSMNR_CACHE keeps its documents on the heap, so it can't be used with JSMNR_NO_HEAP"
+#endif
+#if defined(JSMNR_NO_HEAP) && defined(JSMNR_PATH_CACHE)
+#error "JSMNR_PATH_CACHE keeps its table on the heap, so it can't be used with JSMNR_NO_HEAP"
+#endif
+#if defined(JSMNR_NO_HEAP) && defined(JSMNR_BATCH)
+#error "JSMNR_BATCH gives each of its threads a reader of its own on the heap, so it can't be used with JSMNR_NO_HEAP"
+#endif
+
+/* Slots in a reader's JSMNR_PATH_CACHE table, a power of two. It's emptied when three quarters full */
+#ifndef JSMNR_PATH_CACHE_SIZE
+#define JSMNR_PATH_CACHE_SIZE 256
+#endif
+#if (JSMNR_PATH_CACHE_SIZE & (JSMNR_PATH_CACHE_SIZE - 1)) != 0
+#error "JSMNR_PATH_CACHE_SIZE has to be a power of two"
+#endif
+
+/* Bytes of documents the JSMNR_CACHE cache keeps before evicting, until jsmnreader_cache_budget() changes it */
+#ifndef JSMNR_CACHE_BUDGET
+#define JSMNR_CACHE_BUDGET (64 * 1024 * 1024)
+#endif
+
+/* Documents a JSMNR_BATCH thread takes at a time */
+#ifndef JSMNR_BATCH_CHUNK
+#define JSMNR_BATCH_CHUNK 32
+#endif
+
+/* Deepest nesting of objects and arrays accepted by jsmn_parse() and jsmnreader_validate() */
+#ifndef JSMNR_MAX_DEPTH
+#define JSMNR_MAX_DEPTH 1024
 #endif
 
 	/**
@@ -58,6 +137,23 @@ extern "C" {
 		JSMN_PRIMITIVE = 1 << 3
 	} jsmntype_t;
 
+	/**
+	* Token subtypes, worked out while tokenizing. A number is
+	* JSMN_PRIMITIVE_INT or JSMN_PRIMITIVE_FLOAT, along with
+	* JSMN_PRIMITIVE_NEGATIVE when it starts with '-'. Other primitives
+	* are left as 0. A string holding any escape sequence is
+	* JSMN_STRING_ESCAPED.
+	*/
+	typedef enum {
+		JSMN_PRIMITIVE_NULL = 1 << 0,
+		JSMN_PRIMITIVE_TRUE = 1 << 1,
+		JSMN_PRIMITIVE_FALSE = 1 << 2,
+		JSMN_PRIMITIVE_INT = 1 << 3,
+		JSMN_PRIMITIVE_FLOAT = 1 << 4,
+		JSMN_PRIMITIVE_NEGATIVE = 1 << 5,
+		JSMN_STRING_ESCAPED = 1 << 6
+	} jsmnsubtype_t;
+
 	enum jsmnerr {
 		/* Success! */
 		JSMN_SUCCESS = 0,
@@ -68,7 +164,9 @@ extern "C" {
 		/* The string is not a full JSON packet, more bytes expected */
 		JSMN_ERROR_PART = -3,
 		/* File not found */
-		JSMN_ERROR_NOFILE = -4
+		JSMN_ERROR_NOFILE = -4,
+		/* Objects and arrays nested deeper than JSMNR_MAX_DEPTH */
+		JSMN_ERROR_DEPTH = -5
 	};
 
 	/**
@@ -76,12 +174,14 @@ extern "C" {
 	* type		type (object, array, string etc.)
 	* start	start position in JSON data string
 	* end		end position in JSON data string
+	* subtype	jsmnsubtype_t flags of a primitive or string
 	*/
 	typedef struct jsmntok {
 		jsmntype_t type;
 		int start;
 		int end;
 		int size;
+		int subtype;
 #ifdef JSMN_PARENT_LINKS
 		int parent;
 #endif
@@ -95,6 +195,7 @@ extern "C" {
 		unsigned int pos;     /* offset in the JSON string */
 		unsigned int toknext; /* next token to allocate */
 		int toksuper;         /* superior token node, e.g. parent object or array */
+		unsigned int depth;   /* objects and arrays open at 'pos', at most JSMNR_MAX_DEPTH */
 	} jsmn_parser;
 
 	/**
@@ -112,12 +213,129 @@ extern "C" {
 
 	/* ---- JSMN READER STUFF ---- */
 
+#ifdef JSMNR_STATS
+	/**
+	* (JSMN Reader): Counters kept by a reader when JSMNR_STATS is defined. Read with jsmnreader_stats_get(), cleared with jsmnreader_stats_reset().
+	*/
+	typedef struct jsmnreader_stats_struct
+	{
+		unsigned long long loads; /* jsmnreader_load() calls */
+		unsigned long long load_ns;
+		unsigned long long parse_passes; /* jsmn_parse() runs, a load takes more than one */
+		unsigned long long estimate_misses; /* loads that made more tokens than jsmnreader_token_estimate() gave room for, and had to count them */
+		unsigned long long sidecar_loads; /* jsmnreader_fileload_sidecar() calls that mapped an index back in instead of parsing */
+		unsigned long long bytes_parsed; /* summed over every pass */
+		unsigned long long tokens_emitted;
+		unsigned long long extract_calls; /* strings copied out of the document */
+		unsigned long long extract_bytes;
+		unsigned long long allocations; /* malloc() calls */
+		unsigned long long reallocations; /* realloc() calls */
+		unsigned long long skipped_tokens; /* tokens stepped over when skipping objects and arrays */
+		unsigned long long lookups; /* path lookups, jsmnreader_tree_get_x() and jsmnreader_tree_foreach() */
+		unsigned long long path_cache_hits; /* jsmnreader_tree_get_x() lookups answered by JSMNR_PATH_CACHE */
+		unsigned long long path_cache_misses; /* lookups it had to walk for */
+		unsigned long long lookup_ns;
+	} jsmnreader_stats;
+#endif
+
+#ifdef JSMNR_CACHE
+	/**
+	* (JSMN Reader): Counters of the document cache, read with jsmnreader_cache_stats_get(). Only available with JSMNR_CACHE defined.
+	*/
+	typedef struct jsmnreader_cache_stats_struct
+	{
+		unsigned long long hits; /* jsmnreader_cache_fileload() calls answered from the cache */
+		unsigned long long misses; /* calls that loaded the file, because it wasn't cached or had changed */
+		unsigned long long evictions; /* documents dropped to stay within the budget */
+		unsigned int entries; /* documents cached right now */
+		size_t bytes; /* their text and tokens */
+		size_t budget;
+	} jsmnreader_cache_stats;
+#endif
+
+#if defined(JSMNR_STATS) || defined(JSMNR_TRACE)
+	typedef enum {
+		JSMNR_TRACE_LOAD,
+		JSMNR_TRACE_FILELOAD,
+		JSMNR_TRACE_TREE,
+	} jsmnreadertrace_t;
+
+	/**
+	* (JSMN Reader): A traced call, passed to the hooks set with jsmnreader_trace_set(). Only valid during the hook.
+	*/
+	typedef struct jsmnreader_trace_struct
+	{
+		jsmnreadertrace_t op;
+		const char * path; /* file path for JSMNR_TRACE_FILELOAD, tree path for JSMNR_TRACE_TREE, otherwise NULL */
+		unsigned int offset; /* starting token of a tree lookup */
+		unsigned int bytes; /* size of the reader's JSON string */
+		unsigned int tokens; /* tokens in the reader */
+		int result; /* load error constant, token ID found (-1 when none), or number of matches for jsmnreader_tree_foreach() */
+		unsigned long long start_ns;
+		unsigned long long duration_ns; /* 0 in the begin hook */
+	} jsmnreader_trace;
+#endif
+
+#ifdef JSMNR_TRACE
+	/**
+	* (JSMN Reader): Tracing hook, called at the start and the end of loads and tree lookups.
+	*/
+	typedef void (*jsmnreader_trace_cb)(const jsmnreader_trace * trace, void * userdata);
+#endif
+
+#ifdef JSMNR_PATH_CACHE
+	/* A remembered jsmnreader_tree_get_x() lookup */
+	typedef struct jsmnreader_path_entry_struct
+	{
+		unsigned long long hash; /* of the path */
+		unsigned int generation; /* Matches the reader's while the entry is in use */
+		unsigned int offset;
+		unsigned int token; /* What the lookup returned, -1 included */
+		unsigned int path_start; /* Where the path is in the reader's 'path_chars' */
+		unsigned int path_len;
+	} jsmnreader_path_entry;
+#endif
+
 	typedef struct jsmnreader_obj_struct
 	{
 		char * txt;
 		unsigned int txt_size;
 		jsmntok_t * tokens;
 		unsigned int tokens_count;
+		char * txt_buffer; /* The reader's own text buffer, 'txt' points into it unless the JSON was borrowed */
+		unsigned int txt_capacity; /* Bytes allocated for 'txt_buffer', kept across loads */
+		unsigned int tokens_capacity; /* Tokens allocated for 'tokens', kept across loads */
+		int insitu; /* Whether jsmnreader_insitu() decoded the strings within 'txt' */
+		int frozen; /* Set by jsmnreader_freeze(), so queries don't write to the reader, until the next load or reset */
+#ifdef JSMNR_ARRAY_INDEX
+		unsigned int * array_index; /* Per token, where its array's element table starts in 'array_elements' (+1), 0 if not built yet */
+		unsigned int * array_elements; /* Element token IDs of every array indexed so far, back to back */
+		unsigned int array_elements_count;
+		unsigned int array_capacity; /* Entries allocated in both tables, kept across loads */
+		int array_ready; /* Whether 'array_index' was cleared for the current load */
+#endif
+#ifdef JSMNR_PATH_CACHE
+		jsmnreader_path_entry * path_entries; /* JSMNR_PATH_CACHE_SIZE slots, allocated on the first lookup */
+		char * path_chars; /* The cached paths, back to back */
+		unsigned int path_chars_used;
+		unsigned int path_chars_capacity;
+		unsigned int path_count; /* Slots in use */
+		unsigned int path_generation; /* Moved on by every load, so older entries count as empty */
+#endif
+#ifdef JSMNR_SIDECAR
+		char * map_txt; /* The JSON file mapped in by jsmnreader_fileload_sidecar(), 'txt' points to it */
+		size_t map_txt_size;
+		char * map_index; /* Its sidecar index mapped in alongside, 'tokens' points into it */
+		size_t map_index_size;
+#endif
+#ifdef JSMNR_STATS
+		jsmnreader_stats stats;
+#endif
+#ifdef JSMNR_TRACE
+		jsmnreader_trace_cb trace_begin;
+		jsmnreader_trace_cb trace_end;
+		void * trace_userdata;
+#endif
 	} jsmnreader_obj;
 
 	typedef enum {
@@ -126,26 +344,208 @@ extern "C" {
 		JSMNR_ITEMONLY,
 	} jsmnreaderobjread_t;
 
+	typedef enum {
+		JSMNR_LOAD_OWN,
+		JSMNR_LOAD_BORROW,
+		JSMNR_LOAD_COPY,
+	} jsmnreaderload_t;
+
+	/**
+	* (JSMN Reader): Callback for jsmnreader_tree_foreach(). Receives each matching token ID, return non-zero to stop early.
+	*/
+	typedef int (*jsmnreader_tree_cb)(unsigned int index, void * userdata);
+
+	/**
+	* (JSMN Reader): Cursor over the items of an array or object, meant to live on the stack. Set up with jsmnreader_iter_init().
+	* 'key' holds the key token ID of the item last returned from an object, or -1 (or unsigned 4294967295) for arrays.
+	*/
+	typedef struct jsmnreader_iter_struct
+	{
+		unsigned int offset;
+		unsigned int next;
+		unsigned int remaining;
+		unsigned int key;
+	} jsmnreader_iter;
+
+	typedef enum {
+		JSMNR_COLUMN_INT64,
+		JSMNR_COLUMN_DOUBLE,
+		JSMNR_COLUMN_STRING,
+	} jsmnreadercolumn_t;
+
+	/**
+	* (JSMN Reader): A key read out of every object of an array by jsmnreader_token_array_columns(), and the column its values are written to.
+	*/
+	typedef struct jsmnreader_column_struct
+	{
+		const char * key;
+		jsmnreadercolumn_t type;
+		void * values; /* A long long or double per row, or for JSMNR_COLUMN_STRING an unsigned int offset into the arena (-1 when missing or out of room) */
+		unsigned char * found; /* Per row, 1 when the object had the key with a primitive that fits (or a string, for JSMNR_COLUMN_STRING), 0 otherwise. Can be NULL */
+	} jsmnreader_column;
+
+#ifdef JSMNR_BATCH
+	typedef enum {
+		JSMNR_BATCH_INT,
+		JSMNR_BATCH_UINT,
+		JSMNR_BATCH_FLOAT,
+		JSMNR_BATCH_STRING,
+	} jsmnreaderbatch_t;
+
+	/**
+	* (JSMN Reader): A path looked up in every document of a batch, and the column its values are written to. Only available with JSMNR_BATCH defined.
+	*/
+	typedef struct jsmnreader_batch_column_struct
+	{
+		char * path; /* Tree path from the top of each document */
+		jsmnreaderbatch_t type;
+		void * values; /* An int, unsigned int or float per document, or 'string_size' chars per document for JSMNR_BATCH_STRING */
+		unsigned int string_size; /* Longer strings are cut short, and still end with a '\0' */
+		unsigned char * found; /* Per document, 1 when the path holds a primitive (or a string, for JSMNR_BATCH_STRING), 0 otherwise. Can be NULL */
+	} jsmnreader_batch_column;
+
+	/* A thread of a batch, with the reader it loads its documents into */
+	typedef struct jsmnreader_batch_worker_struct
+	{
+		struct jsmnreader_batch_struct * batch;
+		jsmnreader_obj reader;
+		pthread_t thread;
+	} jsmnreader_batch_worker;
+
+	/**
+	* (JSMN Reader): A pool of threads looking up the same columns over batches of documents. Set up with jsmnreader_batch_init(), and not to be moved or copied afterwards. Only available with JSMNR_BATCH defined.
+	*/
+	typedef struct jsmnreader_batch_struct
+	{
+		jsmnreader_batch_column * columns;
+		unsigned int columns_count;
+		jsmnreader_batch_worker * workers; /* The first is run by the thread calling jsmnreader_batch_run(), the rest have threads of their own */
+		unsigned int workers_count;
+		pthread_mutex_t lock;
+		pthread_cond_t start;
+		pthread_cond_t done;
+		unsigned int generation; /* Moved on by every run, for the threads to wake up to */
+		unsigned int running; /* Threads still working on the current run */
+		int stop;
+		char ** docs; /* The current run */
+		const unsigned int * docs_size;
+		unsigned int docs_count;
+		int * status;
+		unsigned int next; /* First document no thread took yet */
+		unsigned int loaded; /* Documents that loaded so far */
+	} jsmnreader_batch;
+#endif
+
 	/**
 	* (JSMN Reader): Initalizes the reader data, as well as sets up malloc. Should be the first function used.
 	*/
 	JSMN_API void jsmnreader_init(jsmnreader_obj * reader);
 
+#ifdef JSMNR_NO_HEAP
+	/**
+	* (JSMN Reader): Initalizes the reader to use the caller's 'tokens' and 'txt_buffer' (for JSMNR_LOAD_COPY and jsmnreader_fileload()), which it never grows or frees. Only available with JSMNR_NO_HEAP defined.
+	* A load needing more than 'tokens_capacity' tokens or 'txt_capacity' bytes returns JSMN_ERROR_NOMEM. Either buffer can be NULL with a capacity of 0.
+	*/
+	JSMN_API void jsmnreader_init_buffers(jsmntok_t * tokens, unsigned int tokens_capacity, char * txt_buffer, unsigned int txt_capacity, jsmnreader_obj * reader);
+#endif
+
 	/**
 	* (JSMN Reader): Frees the reader data from memory. Should be the last function used.
 	*/
 	JSMN_API void jsmnreader_free(jsmnreader_obj * reader);
 
+	/**
+	* (JSMN Reader): Empties the reader for another load, but keeps its allocated buffers so loading similar sized JSON doesn't allocate again.
+	*/
+	JSMN_API void jsmnreader_reset(jsmnreader_obj * reader);
+
+	/**
+	* (JSMN Reader): Gives back the reader's unused buffer space, sizing its buffers down to the currently loaded JSON.
+	*/
+	JSMN_API void jsmnreader_shrink(jsmnreader_obj * reader);
+
+	/**
+	* (JSMN Reader): Makes the loaded JSON safe to query from many threads at once, by setting up anything queries would otherwise build or allocate inside the reader, and keeping them from writing to it afterwards. JSMNR_STATS counters stop counting while frozen.
+	* The next load, jsmnreader_reset() or jsmnreader_free() thaws it, and jsmnreader_insitu() mustn't be used on it meanwhile. None of those are to be called while other threads still query it.
+	*/
+	JSMN_API void jsmnreader_freeze(jsmnreader_obj * reader);
+
+	/**
+	* (JSMN Reader): Decodes every string of the loaded JSON in place and ends it (and every primitive) with a '\0', so jsmnreader_token_get_insitu() and jsmnreader_tree_get_insitu() can hand them out without allocating. The reader's JSON string is written to, including borrowed ones, and isn't valid JSON afterwards.
+	*/
+	JSMN_API void jsmnreader_insitu(jsmnreader_obj * reader);
+
 	/**
 	* (JSMN Reader): Loads a C string to populate the tokens within the reader. Can return an int for checking errors loading.
 	*/
 	JSMN_API int jsmnreader_load(char * str, unsigned int str_size, struct jsmnreader_obj_struct * reader);
 
+	/**
+	* (JSMN Reader): Loads a C string, with 'mode' (JSMNR_LOAD_OWN, JSMNR_LOAD_BORROW, JSMNR_LOAD_COPY) choosing who owns it. Returns the same error constants as jsmnreader_load().
+	* JSMNR_LOAD_OWN hands 'str' over to the reader, which frees it on the next load or jsmnreader_free(). JSMNR_LOAD_BORROW parses 'str' in place and never frees it, so it has to outlive the reader's use of it. JSMNR_LOAD_COPY copies 'str' into the reader's own buffer, which is kept across loads.
+	*/
+	JSMN_API int jsmnreader_load_mode(char * str, unsigned int str_size, jsmnreaderload_t mode, struct jsmnreader_obj_struct * reader);
+
 	/**
 	* (JSMN Reader): Loads a C string from a text file to populate the tokens within the reader. Can return an int for checking errors loading.
 	*/
 	JSMN_API int jsmnreader_fileload(char * filepath, struct jsmnreader_obj_struct * reader);
 
+#ifdef JSMNR_SIDECAR
+	/**
+	* (JSMN Reader): Loads a text file like jsmnreader_fileload(), keeping its tokens in a sidecar index file at 'sidecar_path' (or 'filepath' with ".jsmnr" added when NULL). Only available with JSMNR_SIDECAR defined.
+	* When the index matches the file's size, modification time, device and inode (and hash, with JSMNR_SIDECAR_HASH defined), and every token lies within the file, the file and its tokens are memory mapped straight back in without parsing. Otherwise the file is parsed and the index written again. The mappings are private, so changes never reach either file, and are let go of on the next load or jsmnreader_free().
+	*/
+	JSMN_API int jsmnreader_fileload_sidecar(char * filepath, char * sidecar_path, struct jsmnreader_obj_struct * reader);
+#endif
+
+#ifdef JSMNR_CACHE
+	/**
+	* (JSMN Reader): Returns a reader with 'filepath' loaded from the process-wide document cache, loading it when it isn't cached or the file's device, inode, size or modification time changed. Returns NULL on failure, with the load error in 'error' if it isn't NULL. Only available with JSMNR_CACHE defined.
+	* The reader is shared, so it's only to be queried, never loaded into, jsmnreader_insitu()'d or freed. Give it back with jsmnreader_cache_release() once done. Safe to call from any thread.
+	*/
+	JSMN_API jsmnreader_obj * jsmnreader_cache_fileload(const char * filepath, int * error);
+
+	/**
+	* (JSMN Reader): Gives back a reader from jsmnreader_cache_fileload(). It stays cached for later calls until evicted. Only available with JSMNR_CACHE defined.
+	*/
+	JSMN_API void jsmnreader_cache_release(jsmnreader_obj * reader);
+
+	/**
+	* (JSMN Reader): Sets how many bytes of text and tokens the cache keeps, evicting the least recently used documents that nobody holds until it fits. Only available with JSMNR_CACHE defined.
+	*/
+	JSMN_API void jsmnreader_cache_budget(size_t bytes);
+
+	/**
+	* (JSMN Reader): Drops every cached document that nobody holds, such as before exiting. Only available with JSMNR_CACHE defined.
+	*/
+	JSMN_API void jsmnreader_cache_clear(void);
+
+	/**
+	* (JSMN Reader): Copies the cache's counters into 'stats'. Only available with JSMNR_CACHE defined.
+	*/
+	JSMN_API void jsmnreader_cache_stats_get(jsmnreader_cache_stats * stats);
+#endif
+
+#ifdef JSMNR_BATCH
+	/**
+	* (JSMN Reader): Sets up 'batch' to look up 'columns' in documents with 'threads' threads (0 for one per CPU), the calling thread counted. Returns JSMN_SUCCESS, or JSMN_ERROR_NOMEM if the memory or any of the threads couldn't be had, leaving nothing to free. Only available with JSMNR_BATCH defined.
+	* The columns are used in place rather than copied, so their 'values' and 'found' can be pointed elsewhere between runs.
+	*/
+	JSMN_API int jsmnreader_batch_init(jsmnreader_batch_column * columns, unsigned int columns_count, unsigned int threads, jsmnreader_batch * batch);
+
+	/**
+	* (JSMN Reader): Loads each of 'docs' (borrowed, 'docs_size' bytes each) and writes what every column's path holds to the column's entry for that document, 0 or "" where it holds nothing. Puts each document's load error constant into 'status' when it isn't NULL, and returns how many loaded. Only available with JSMNR_BATCH defined.
+	* The documents are shared out between the batch's threads, each loading into a reader of its own that keeps its buffers across documents and runs. Only one run at a time per batch.
+	*/
+	JSMN_API unsigned int jsmnreader_batch_run(char ** docs, const unsigned int * docs_size, unsigned int docs_count, int * status, jsmnreader_batch * batch);
+
+	/**
+	* (JSMN Reader): Stops the batch's threads and frees its readers. Only available with JSMNR_BATCH defined.
+	*/
+	JSMN_API void jsmnreader_batch_free(jsmnreader_batch * batch);
+#endif
+
 	/**
 	* (JSMN Reader): Outputs the raw string contents of the reader's JSON string.
 	*/
@@ -156,6 +556,43 @@ extern "C" {
 	*/
 	JSMN_API void jsmnreader_print_tokens(jsmnreader_obj * reader);
 
+	/**
+	* (JSMN Reader): Checks that 'str' is one well-formed JSON value (RFC 8259, UTF-8 strings included) without making any tokens or allocating. Returns JSMN_SUCCESS, JSMN_ERROR_INVAL, JSMN_ERROR_PART if it ends early, or JSMN_ERROR_DEPTH if it nests deeper than JSMNR_MAX_DEPTH.
+	* If 'error_pos' isn't NULL, it's set to where the check stopped.
+	*/
+	JSMN_API int jsmnreader_validate(const char * str, unsigned int str_size, unsigned int * error_pos);
+
+	/**
+	* (JSMN Reader): Checks that 'str' is valid UTF-8 (no overlong forms, surrogates or code points past U+10FFFF). Returns JSMN_SUCCESS, JSMN_ERROR_INVAL, or JSMN_ERROR_PART if it ends in the middle of a character.
+	* If 'error_pos' isn't NULL, it's set to where the check stopped. With JSMNR_UTF8_VALIDATE defined, every load runs this on its JSON string.
+	*/
+	JSMN_API int jsmnreader_utf8_validate(const char * str, unsigned int str_size, unsigned int * error_pos);
+
+	/**
+	* (JSMN Reader): Guesses how many tokens loading 'str' makes, from how many '{', '[', ',' and ':' it has. That's enough for any single JSON value, so loads use it to size the tokens without counting them first.
+	* Without the heap, it's a quick way to size the buffers given to jsmnreader_init_buffers().
+	*/
+	JSMN_API unsigned int jsmnreader_token_estimate(const char * str, unsigned int str_size);
+
+#ifdef JSMNR_STATS
+	/**
+	* (JSMN Reader): Copies the reader's counters into 'stats'. Only available with JSMNR_STATS defined.
+	*/
+	JSMN_API void jsmnreader_stats_get(jsmnreader_obj * reader, jsmnreader_stats * stats);
+
+	/**
+	* (JSMN Reader): Sets all of the reader's counters back to 0. Only available with JSMNR_STATS defined.
+	*/
+	JSMN_API void jsmnreader_stats_reset(jsmnreader_obj * reader);
+#endif
+
+#ifdef JSMNR_TRACE
+	/**
+	* (JSMN Reader): Sets the hooks called around jsmnreader_load(), jsmnreader_fileload() and each path lookup of the jsmnreader_tree_* functions. Either hook can be NULL. Only available with JSMNR_TRACE defined.
+	*/
+	JSMN_API void jsmnreader_trace_set(jsmnreader_trace_cb begin, jsmnreader_trace_cb end, void * userdata, struct jsmnreader_obj_struct * reader);
+#endif
+
 	/**
 	* (JSMN Reader): Returns an int if the token successfully found. Returns 0 in failure.
 	*/
@@ -171,6 +608,7 @@ extern "C" {
 	*/
 	JSMN_API float jsmnreader_token_get_float(unsigned int index, jsmnreader_obj * reader);
 
+#ifndef JSMNR_NO_HEAP
 	/**
 	* (JSMN Reader): Returns an allocated C string if the token was successfully found; it also can be used to grab the key string. Returns as a blank string in failure. Compatible with other types of items. Remember to free the C string after usage.
 	*/
@@ -180,6 +618,22 @@ extern "C" {
 	* (JSMN Reader): Returns an allocated C string of "raw" contents (strings with quotations, true/false/null, etc.) if the token was successfully found; it also can be used to grab the key string. Returns as a blank string in failure. Remember to free the C string after usage.
 	*/
 	JSMN_API char * jsmnreader_token_get_raw(unsigned int index, jsmnreader_obj * reader);
+#endif
+
+	/**
+	* (JSMN Reader): Copies the string or primitive token's C string into 'buffer', decoded the same as jsmnreader_token_get_string(), writing at most 'buffer_size' bytes including the '\0'. Returns the full length of the string, so a result of 'buffer_size' or more means it was cut short. Returns -1 in failure.
+	*/
+	JSMN_API int jsmnreader_token_copy_string(unsigned int index, char * buffer, unsigned int buffer_size, jsmnreader_obj * reader);
+
+	/**
+	* (JSMN Reader): Returns the C string of a string or primitive token from within the reader's JSON string, after jsmnreader_insitu(). Returns NULL in failure, or before jsmnreader_insitu(). Don't free it, it lasts until the next load.
+	*/
+	JSMN_API const char * jsmnreader_token_get_insitu(unsigned int index, jsmnreader_obj * reader);
+
+	/**
+	* (JSMN Reader): Returns the primitive's subtype flags (JSMN_PRIMITIVE_NULL, JSMN_PRIMITIVE_TRUE, JSMN_PRIMITIVE_FALSE, JSMN_PRIMITIVE_INT, JSMN_PRIMITIVE_FLOAT, JSMN_PRIMITIVE_NEGATIVE) if the token was successfully found. Returns 0 in failure.
+	*/
+	JSMN_API int jsmnreader_token_subtype(unsigned int index, jsmnreader_obj * reader);
 
 	/**
 	* (JSMN Reader): Returns a 1 if the null token was successfully found. Returns 0 in failure.
@@ -209,19 +663,78 @@ extern "C" {
 	/**
 	* (JSMN Reader): Returns the token's ID if the token was successfully found. On failure to locate the token, it returns as -1 (or unsigned 4294967295).
 	* 'mypath' usage appears as "repository\\type" like a filepath, use a blank string "" if you want to grab from the root from the 'offset'. Generally, 'offset' comes from object/array-related output.
+	* Within arrays, a segment is an element index ("items\\3\\price"). A "*" segment matches every key or element, and the first match is returned.
 	*/
 	JSMN_API unsigned int jsmnreader_tree_get_x(char * mypath, unsigned int offset, struct jsmnreader_obj_struct * reader);
 
 	/**
-	* (JSMN Reader): Returns the token's ID if the token was successfully found. 
+	* (JSMN Reader): Calls 'callback' with the ID of every token matching the path, in document order. Returns the number of matches.
+	* Uses the same path syntax as jsmnreader_tree_get_x(), "*" segments being the ones that can match more than once.
+	*/
+	JSMN_API unsigned int jsmnreader_tree_foreach(char * mypath, unsigned int offset, jsmnreader_tree_cb callback, void * userdata, struct jsmnreader_obj_struct * reader);
+
+#ifndef JSMNR_NO_HEAP
+	/**
+	* (JSMN Reader): Populates an unsigned int array with the indexes of the array's tokens. Remember to free the array after usage.
 	*/
 	JSMN_API void jsmnreader_token_array_tokens(unsigned int ** arrays, unsigned int * arrays_size, unsigned int offset, struct jsmnreader_obj_struct * reader);
+#endif
+
+	/**
+	* (JSMN Reader): Fills 'buffer' with up to 'buffer_size' indexes of the array's tokens. Returns how many indexes the array has, which can be more than were written.
+	*/
+	JSMN_API unsigned int jsmnreader_token_array_fill(unsigned int * buffer, unsigned int buffer_size, unsigned int offset, struct jsmnreader_obj_struct * reader);
+
+	/**
+	* (JSMN Reader): Reads an array of objects into columns in one pass, writing each column's value for the first 'rows_capacity' objects (a row each), and 0 (or -1 for strings) where an object lacks the key. Returns how many items the array has, which can be more than were written.
+	* Strings are decoded into 'arena' back to back, each ending with a '\0'. 'arena_used' (if not NULL) gets the bytes they needed, which when over 'arena_size' means some were left out.
+	* Numbers are read by value: JSMNR_COLUMN_INT64 applies exponents before cutting decimals toward zero, so "1e5" is 100000 where jsmnreader_token_get_int() gives 1. Numbers past the column type's range are written as 0, as if missing.
+	*/
+	JSMN_API unsigned int jsmnreader_token_array_columns(jsmnreader_column * columns, unsigned int columns_count, unsigned int rows_capacity, char * arena, unsigned int arena_size, unsigned int * arena_used, unsigned int offset, struct jsmnreader_obj_struct * reader);
+
+	/**
+	* (JSMN Reader): Decodes the array's first 'buffer_size' items into 'buffer' as ints, in one pass. Returns how many items the array has, which can be more than were written.
+	* Items that aren't numbers, or don't fit, are written as 0, and the first one's index goes in 'error_index' (if not NULL), which is otherwise -1 (or unsigned 4294967295). Exponents are applied before decimals are cut toward zero, so "1e5" is 100000 where jsmnreader_token_get_int() gives 1.
+	*/
+	JSMN_API unsigned int jsmnreader_token_array_get_int32(int * buffer, unsigned int buffer_size, unsigned int * error_index, unsigned int offset, struct jsmnreader_obj_struct * reader);
+
+	/**
+	* (JSMN Reader): Same as jsmnreader_token_array_get_int32(), into long longs.
+	*/
+	JSMN_API unsigned int jsmnreader_token_array_get_int64(long long * buffer, unsigned int buffer_size, unsigned int * error_index, unsigned int offset, struct jsmnreader_obj_struct * reader);
+
+	/**
+	* (JSMN Reader): Same as jsmnreader_token_array_get_int32(), into floats, rounded the same as jsmnreader_token_get_float(). Numbers past a float's range count as errors.
+	*/
+	JSMN_API unsigned int jsmnreader_token_array_get_float(float * buffer, unsigned int buffer_size, unsigned int * error_index, unsigned int offset, struct jsmnreader_obj_struct * reader);
+
+	/**
+	* (JSMN Reader): Same as jsmnreader_token_array_get_int32(), into doubles. Numbers past a double's range count as errors.
+	*/
+	JSMN_API unsigned int jsmnreader_token_array_get_double(double * buffer, unsigned int buffer_size, unsigned int * error_index, unsigned int offset, struct jsmnreader_obj_struct * reader);
 
 	/**
 	* (JSMN Reader): Returns a token ID from a specified index within the array's tokens. On failure to locate the token, it returns as -1 (or unsigned 4294967295).
+	* With JSMNR_ARRAY_INDEX defined, the array's element table is built on first use and later lookups are O(1).
 	*/
 	JSMN_API unsigned int jsmnreader_token_array(unsigned int index, unsigned int offset, struct jsmnreader_obj_struct * reader);
 
+	/**
+	* (JSMN Reader): Returns the token ID of the element after 'index' within the array at 'offset'. On reaching the end of the array, it returns as -1 (or unsigned 4294967295).
+	* Start from jsmnreader_token_array(0, offset, &reader) to walk the whole array, each step skips just the one element.
+	*/
+	JSMN_API unsigned int jsmnreader_token_array_next(unsigned int index, unsigned int offset, struct jsmnreader_obj_struct * reader);
+
+	/**
+	* (JSMN Reader): Sets up the cursor to walk the array or object at 'offset'. Returns 1 if 'offset' is an array or object, otherwise 0 and the cursor is left empty.
+	*/
+	JSMN_API int jsmnreader_iter_init(jsmnreader_iter * iter, unsigned int offset, struct jsmnreader_obj_struct * reader);
+
+	/**
+	* (JSMN Reader): Returns the token ID of the next array element, or the next object item (with its key in 'iter->key'). On reaching the end, it returns as -1 (or unsigned 4294967295).
+	*/
+	JSMN_API unsigned int jsmnreader_iter_next(jsmnreader_iter * iter, struct jsmnreader_obj_struct * reader);
+
 	/**
 	* (JSMN Reader): Outputs the token if the token was successfully found from the path.
 	*/
@@ -245,6 +758,7 @@ extern "C" {
 	*/
 	JSMN_API float jsmnreader_tree_get_float(char * mypath, unsigned int offset, struct jsmnreader_obj_struct * reader);
 
+#ifndef JSMNR_NO_HEAP
 	/**
 	* (JSMN Reader): Returns an allocated C string if the token was successfully found. Returns as a blank string in failure. Compatible with other types of items. Remember to free the C string after usage.
 	* 'mypath' usage appears as "repository\\type" like a filepath, use a blank string "" if you want to grab from the root from the 'offset'. Generally, 'offset' comes from object/array-related output.
@@ -256,6 +770,19 @@ extern "C" {
 	* 'mypath' usage appears as "repository\\type" like a filepath, use a blank string "" if you want to grab from the root from the 'offset'. Generally, 'offset' comes from object/array-related output.
 	*/
 	JSMN_API char * jsmnreader_tree_get_raw(char * mypath, unsigned int offset, struct jsmnreader_obj_struct * reader);
+#endif
+
+	/**
+	* (JSMN Reader): Copies the token's C string into 'buffer' the same way as jsmnreader_token_copy_string(). Returns the full length of the string, or -1 in failure.
+	* 'mypath' usage appears as "repository\\type" like a filepath, use a blank string "" if you want to grab from the root from the 'offset'. Generally, 'offset' comes from object/array-related output.
+	*/
+	JSMN_API int jsmnreader_tree_copy_string(char * mypath, unsigned int offset, char * buffer, unsigned int buffer_size, struct jsmnreader_obj_struct * reader);
+
+	/**
+	* (JSMN Reader): Returns the C string of a string or primitive token from within the reader's JSON string, after jsmnreader_insitu(). Returns NULL in failure, or before jsmnreader_insitu(). Don't free it, it lasts until the next load.
+	* 'mypath' usage appears as "repository\\type" like a filepath, use a blank string "" if you want to grab from the root from the 'offset'. Generally, 'offset' comes from object/array-related output.
+	*/
+	JSMN_API const char * jsmnreader_tree_get_insitu(char * mypath, unsigned int offset, struct jsmnreader_obj_struct * reader);
 
 	/**
 	* (JSMN Reader): Returns the token's ID if the object token was successfully found. On failure to locate the token, it returns as -1 (or unsigned 4294967295).
@@ -275,11 +802,19 @@ extern "C" {
 	*/
 	JSMN_API unsigned int jsmnreader_tree_get_any(char * mypath, unsigned int offset, struct jsmnreader_obj_struct * reader);
 
+#ifndef JSMNR_NO_HEAP
     /**
 	* (JSMN Reader): Populates an unsigned int array with the indexes of the object's tokens.
 	* 'read_setting' makes use of the 'jsmnreaderobjread_t' enum (JSMNR_BOTH, JSMNR_KEYONLY, JSMNR_ITEMONLY) for listing the tokens within the object.
 	*/
 	JSMN_API void jsmnreader_token_object_tokens(unsigned int ** arrays, unsigned int * arrays_size, unsigned int offset, jsmnreaderobjread_t read_setting, struct jsmnreader_obj_struct * reader);
+#endif
+
+	/**
+	* (JSMN Reader): Fills 'buffer' with up to 'buffer_size' indexes of the object's tokens. Returns how many indexes the object has for 'read_setting', which can be more than were written.
+	* 'read_setting' makes use of the 'jsmnreaderobjread_t' enum (JSMNR_BOTH, JSMNR_KEYONLY, JSMNR_ITEMONLY) for listing the tokens within the object.
+	*/
+	JSMN_API unsigned int jsmnreader_token_object_fill(unsigned int * buffer, unsigned int buffer_size, unsigned int offset, jsmnreaderobjread_t read_setting, struct jsmnreader_obj_struct * reader);
 
 	/**
 	* (JSMN Reader): Returns a token ID from a specified index within the object's tokens. On failure to locate the token, it returns as -1 (or unsigned 4294967295).
@@ -313,6 +848,7 @@ extern "C" {
         //{
 		tok->start = tok->end = -1;
 		tok->size = 0;
+		tok->subtype = 0;
 #ifdef JSMN_PARENT_LINKS
 		tok->parent = -1;
 #endif
@@ -332,6 +868,61 @@ extern "C" {
 		token->size = 0;
 	}
 
+	/**
+	* Works out the subtype of the primitive between start and end.
+	*/
+	static int jsmn_primitive_subtype(const char *js, const unsigned int start,
+		const unsigned int end) {
+		unsigned int i;
+		int subtype;
+		switch (js[start]) {
+		case 'n':
+			return (end - start == 4 && memcmp(js + start, "null", 4) == 0) ? JSMN_PRIMITIVE_NULL : 0;
+		case 't':
+			return (end - start == 4 && memcmp(js + start, "true", 4) == 0) ? JSMN_PRIMITIVE_TRUE : 0;
+		case 'f':
+			return (end - start == 5 && memcmp(js + start, "false", 5) == 0) ? JSMN_PRIMITIVE_FALSE : 0;
+		default:
+			break;
+		}
+		i = start;
+		subtype = JSMN_PRIMITIVE_INT;
+		if (js[i] == '-') {
+			subtype |= JSMN_PRIMITIVE_NEGATIVE;
+			i++;
+		}
+		if (i == end || js[i] < '0' || js[i] > '9') {
+			return 0;
+		}
+		while (i < end && js[i] >= '0' && js[i] <= '9') {
+			i++;
+		}
+		if (i < end && js[i] == '.') {
+			subtype = (subtype & JSMN_PRIMITIVE_NEGATIVE) | JSMN_PRIMITIVE_FLOAT;
+			i++;
+			if (i == end || js[i] < '0' || js[i] > '9') {
+				return 0;
+			}
+			while (i < end && js[i] >= '0' && js[i] <= '9') {
+				i++;
+			}
+		}
+		if (i < end && (js[i] == 'e' || js[i] == 'E')) {
+			subtype = (subtype & JSMN_PRIMITIVE_NEGATIVE) | JSMN_PRIMITIVE_FLOAT;
+			i++;
+			if (i < end && (js[i] == '+' || js[i] == '-')) {
+				i++;
+			}
+			if (i == end || js[i] < '0' || js[i] > '9') {
+				return 0;
+			}
+			while (i < end && js[i] >= '0' && js[i] <= '9') {
+				i++;
+			}
+		}
+		return i == end ? subtype : 0;
+	}
+
 	/**
 	* Fills next available token with JSON primitive.
 	*/
@@ -379,6 +970,7 @@ extern "C" {
 			return JSMN_ERROR_NOMEM;
 		}
 		jsmn_fill_token(token, JSMN_PRIMITIVE, start, parser->pos);
+		token->subtype = jsmn_primitive_subtype(js, start, parser->pos);
 #ifdef JSMN_PARENT_LINKS
 		token->parent = parser->toksuper;
 #endif
@@ -394,6 +986,7 @@ extern "C" {
 		const unsigned int num_tokens,
 		const unsigned int parsemode_sizecheck) {
 		jsmntok_t *token;
+		int escaped = 0;
 
 		int start = parser->pos;
 
@@ -414,6 +1007,9 @@ extern "C" {
 					return JSMN_ERROR_NOMEM;
 				}
 				jsmn_fill_token(token, JSMN_STRING, start + 1, parser->pos);
+				if (escaped) {
+					token->subtype = JSMN_STRING_ESCAPED;
+				}
 #ifdef JSMN_PARENT_LINKS
 				token->parent = parser->toksuper;
 #endif
@@ -423,6 +1019,7 @@ extern "C" {
 			/* Backslash: Quoted symbol expected */
 			if (c == '\\' && parser->pos + 1 < len) {
 				int i;
+				escaped = 1;
 				parser->pos++;
 				switch (js[parser->pos]) {
 					/* Allowed escaped symbols */
@@ -480,6 +1077,11 @@ extern "C" {
 			switch (c) {
 			case '{':
 			case '[':
+				/* Too deep to be walked safely afterwards */
+				if (parser->depth >= JSMNR_MAX_DEPTH) {
+					return JSMN_ERROR_DEPTH;
+				}
+				parser->depth++;
 				count++;
 				if (tokens == NULL) {
 					break;
@@ -507,6 +1109,9 @@ extern "C" {
 				break;
 			case '}':
 			case ']':
+				if (parser->depth > 0) {
+					parser->depth--;
+				}
 				if (tokens == NULL) {
 					break;
 				}
@@ -656,102 +1261,1851 @@ extern "C" {
 		parser->pos = 0;
 		parser->toknext = 0;
 		parser->toksuper = -1;
+		parser->depth = 0;
 	}
 
 	/* ---- JSMN READER STUFF (FUNCTIONS) ---- */
 
-	JSMN_API void jsmnreader_init(jsmnreader_obj * reader)
+#ifdef JSMNR_STATS
+#define JSMNR_STAT_ADD(reader, field, n) ((reader)->frozen ? (void)0 : (void)((reader)->stats.field += (n)))
+#else
+#define JSMNR_STAT_ADD(reader, field, n) ((void)(reader))
+#endif
+
+/* Set here from JSMNR_STATS and JSMNR_TRACE only, whatever the including file defined it as */
+#undef JSMNR_SPANS
+#if defined(JSMNR_STATS) || defined(JSMNR_TRACE)
+#define JSMNR_SPANS
+#ifndef JSMNR_CLOCK_NS
+	static unsigned long long jsmnreader_clock_ns(void)
 	{
-		reader->txt = (char *) malloc(0);
-		reader->tokens = (jsmntok_t *) malloc(0);
-		reader->txt_size = 0;
-		reader->tokens_count = 0;
+#if defined(CLOCK_MONOTONIC)
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#elif defined(TIME_UTC)
+		struct timespec ts;
+		timespec_get(&ts, TIME_UTC);
+		return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+		return (unsigned long long)clock() * (1000000000ULL / CLOCKS_PER_SEC);
+#endif
 	}
+#define JSMNR_CLOCK_NS() jsmnreader_clock_ns()
+#endif
 
-	JSMN_API void jsmnreader_free(jsmnreader_obj * reader)
+	static void jsmnreader_span_begin(jsmnreader_trace * span, jsmnreadertrace_t op, const char * path, unsigned int offset, struct jsmnreader_obj_struct * reader)
 	{
-		free(reader->txt);
-		free(reader->tokens);
-		reader->txt_size = 0;
-		reader->tokens_count = 0;
+		span->op = op;
+		span->path = path;
+		span->offset = offset;
+		span->bytes = reader->txt_size;
+		span->tokens = reader->tokens_count;
+		span->result = 0;
+		span->duration_ns = 0;
+		span->start_ns = JSMNR_CLOCK_NS();
+#ifdef JSMNR_TRACE
+		if (reader->trace_begin)
+		{
+			reader->trace_begin(span, reader->trace_userdata);
+			span->start_ns = JSMNR_CLOCK_NS();
+		}
+#endif
 	}
 
-	JSMN_API int jsmnreader_load(char * str, unsigned int str_size, struct jsmnreader_obj_struct * reader)
+	static void jsmnreader_span_end(jsmnreader_trace * span, int result, struct jsmnreader_obj_struct * reader)
 	{
-		jsmn_parser parser;
-		int check;
-		unsigned int i;
-		reader->txt = str;
-		reader->txt_size = str_size;
-		reader->tokens_count = 2;
-		i = 0;
+		span->duration_ns = JSMNR_CLOCK_NS() - span->start_ns;
+		span->result = result;
+		span->bytes = reader->txt_size;
+		span->tokens = reader->tokens_count;
+#ifdef JSMNR_STATS
+		if (!reader->frozen)
+		{
+			switch (span->op)
+			{
+			case JSMNR_TRACE_LOAD:
+				reader->stats.loads++;
+				reader->stats.load_ns += span->duration_ns;
+				break;
+			case JSMNR_TRACE_TREE:
+				reader->stats.lookups++;
+				reader->stats.lookup_ns += span->duration_ns;
+				break;
+			default:
+				break;
+			}
+		}
+#endif
+#ifdef JSMNR_TRACE
+		if (reader->trace_end)
+			reader->trace_end(span, reader->trace_userdata);
+#endif
+	}
+#endif
+
+	/* A load gives back buffer space once it's JSMNR_SHRINK_RATIO times what the JSON needs and over JSMNR_SHRINK_MIN bytes */
+#ifndef JSMNR_SHRINK_RATIO
+#define JSMNR_SHRINK_RATIO 8
+#endif
+#ifndef JSMNR_SHRINK_MIN
+#define JSMNR_SHRINK_MIN 65536
+#endif
+
+#ifndef JSMNR_NO_HEAP
+	static void * jsmnreader_malloc(size_t size, struct jsmnreader_obj_struct * reader)
+	{
+		JSMNR_STAT_ADD(reader, allocations, 1);
+		return malloc(size);
+	}
+
+	static void * jsmnreader_realloc(void * ptr, size_t size, struct jsmnreader_obj_struct * reader)
+	{
+		JSMNR_STAT_ADD(reader, reallocations, 1);
+		return realloc(ptr, size);
+	}
+
+#endif
+#if defined(JSMNR_SIDECAR) || defined(JSMNR_PATH_CACHE) || defined(JSMNR_CACHE)
+	static unsigned long long jsmnreader_hash(const char * str, size_t size)
+	{
+		//For telling files and paths apart, not for security, so 8 bytes at a time is plenty
+		unsigned long long hash;
+		unsigned long long word;
+		size_t pos;
+		hash = 14695981039346656037ULL;
+		for (pos = 0; pos + 8 <= size; pos += 8)
+		{
+			memcpy(&word, str + pos, 8);
+			hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+			hash ^= hash >> 32;
+		}
+		for (; pos < size; pos++)
+			hash = (hash ^ (unsigned char)str[pos]) * 1099511628211ULL;
+		return hash ^ (hash >> 29);
+	}
+
+#endif
+#ifdef JSMNR_PATH_CACHE
+	static void jsmnreader_path_invalidate(struct jsmnreader_obj_struct * reader)
+	{
+		//Empties the table without touching it, unless the generation wraps around
+		reader->path_count = 0;
+		reader->path_chars_used = 0;
+		reader->path_generation++;
+		if (reader->path_generation == 0)
+		{
+			if (reader->path_entries != NULL)
+				memset(reader->path_entries, 0, JSMNR_PATH_CACHE_SIZE * sizeof(jsmnreader_path_entry));
+			reader->path_generation = 1;
+		}
+	}
+
+	static jsmnreader_path_entry * jsmnreader_path_find(char * mypath, unsigned int path_len, unsigned long long hash, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		//Returns the entry of the lookup, or the empty slot it would go into
+		jsmnreader_path_entry * entry;
+		unsigned int slot;
+		slot = (unsigned int)(hash ^ (offset * 0x9E3779B9u)) & (JSMNR_PATH_CACHE_SIZE - 1);
+		for (;;)
+		{
+			entry = reader->path_entries + slot;
+			if (entry->generation != reader->path_generation)
+				return entry;
+			if (entry->hash == hash && entry->offset == offset && entry->path_len == path_len && memcmp(reader->path_chars + entry->path_start, mypath, path_len) == 0)
+				return entry;
+			slot = (slot + 1) & (JSMNR_PATH_CACHE_SIZE - 1);
+		}
+	}
+
+	static void jsmnreader_path_insert(jsmnreader_path_entry * entry, char * mypath, unsigned int path_len, unsigned long long hash, unsigned int offset, unsigned int token, struct jsmnreader_obj_struct * reader)
+	{
+		char * chars;
+		unsigned int capacity;
+		if (reader->path_chars == NULL || reader->path_chars_used + path_len > reader->path_chars_capacity)
+		{
+			capacity = (reader->path_chars_capacity > 0) ? reader->path_chars_capacity * 2 : 1024;
+			while (capacity < reader->path_chars_used + path_len)
+				capacity *= 2;
+			chars = (char *)jsmnreader_realloc(reader->path_chars, capacity, reader);
+			if (chars == NULL)
+				return;
+			reader->path_chars = chars;
+			reader->path_chars_capacity = capacity;
+		}
+		memcpy(reader->path_chars + reader->path_chars_used, mypath, path_len);
+		entry->hash = hash;
+		entry->generation = reader->path_generation;
+		entry->offset = offset;
+		entry->token = token;
+		entry->path_start = reader->path_chars_used;
+		entry->path_len = path_len;
+		reader->path_chars_used += path_len;
+		reader->path_count++;
+	}
 
-		jsmn_init(&parser);
+#endif
+	JSMN_API void jsmnreader_init(jsmnreader_obj * reader)
+	{
+#ifdef JSMNR_STATS
+		memset(&reader->stats, 0, sizeof(reader->stats));
+#endif
+#ifdef JSMNR_TRACE
+		reader->trace_begin = NULL;
+		reader->trace_end = NULL;
+		reader->trace_userdata = NULL;
+#endif
+		reader->txt = NULL;
+		reader->txt_buffer = NULL;
+		reader->tokens = NULL;
+		reader->txt_size = 0;
+		reader->tokens_count = 0;
+		reader->txt_capacity = 0;
+		reader->tokens_capacity = 0;
+		reader->insitu = 0;
+		reader->frozen = 0;
+#ifdef JSMNR_SIDECAR
+		reader->map_txt = NULL;
+		reader->map_txt_size = 0;
+		reader->map_index = NULL;
+		reader->map_index_size = 0;
+#endif
+#ifdef JSMNR_ARRAY_INDEX
+		reader->array_index = NULL;
+		reader->array_elements = NULL;
+		reader->array_elements_count = 0;
+		reader->array_capacity = 0;
+		reader->array_ready = 0;
+#endif
+#ifdef JSMNR_PATH_CACHE
+		reader->path_entries = NULL;
+		reader->path_chars = NULL;
+		reader->path_chars_used = 0;
+		reader->path_chars_capacity = 0;
+		reader->path_count = 0;
+		reader->path_generation = 1;
+#endif
+	}
+
+#ifdef JSMNR_NO_HEAP
+	JSMN_API void jsmnreader_init_buffers(jsmntok_t * tokens, unsigned int tokens_capacity, char * txt_buffer, unsigned int txt_capacity, jsmnreader_obj * reader)
+	{
+		jsmnreader_init(reader);
+		reader->tokens = tokens;
+		reader->tokens_capacity = tokens_capacity;
+		reader->txt_buffer = txt_buffer;
+		reader->txt_capacity = txt_capacity;
+	}
+#endif
 
-		reader->tokens = (jsmntok_t *)realloc(reader->tokens, 0);
-		check = jsmn_parse(&parser, reader->txt, reader->txt_size, reader->tokens, reader->tokens_count, 1);
-		if (check>=0)
-			reader->tokens_count=check;
+#ifdef JSMNR_SIDECAR
+	static void jsmnreader_unmap(struct jsmnreader_obj_struct * reader)
+	{
+		//Mapped tokens aren't the reader's to grow, so it starts over with its own on the next load
+		if (reader->map_index != NULL)
+		{
+			munmap(reader->map_index, reader->map_index_size);
+			reader->map_index = NULL;
+			reader->map_index_size = 0;
+			reader->tokens = NULL;
+			reader->tokens_count = 0;
+		}
+		if (reader->map_txt != NULL)
+		{
+			munmap(reader->map_txt, reader->map_txt_size);
+			reader->map_txt = NULL;
+			reader->map_txt_size = 0;
+			reader->txt = NULL;
+			reader->txt_size = 0;
+		}
+	}
+
+#endif
+	JSMN_API void jsmnreader_free(jsmnreader_obj * reader)
+	{
+#ifdef JSMNR_SIDECAR
+		jsmnreader_unmap(reader);
+#endif
+		//Without the heap the buffers are the caller's, and are only let go of
+#ifndef JSMNR_NO_HEAP
+		free(reader->txt_buffer);
+		free(reader->tokens);
+#endif
+		reader->txt = NULL;
+		reader->txt_buffer = NULL;
+		reader->tokens = NULL;
+		reader->txt_size = 0;
+		reader->tokens_count = 0;
+		reader->txt_capacity = 0;
+		reader->tokens_capacity = 0;
+		reader->frozen = 0;
+#ifdef JSMNR_ARRAY_INDEX
+		free(reader->array_index);
+		free(reader->array_elements);
+		reader->array_index = NULL;
+		reader->array_elements = NULL;
+		reader->array_elements_count = 0;
+		reader->array_capacity = 0;
+		reader->array_ready = 0;
+#endif
+#ifdef JSMNR_PATH_CACHE
+		free(reader->path_entries);
+		free(reader->path_chars);
+		reader->path_entries = NULL;
+		reader->path_chars = NULL;
+		reader->path_chars_used = 0;
+		reader->path_chars_capacity = 0;
+		reader->path_count = 0;
+#endif
+	}
+
+	JSMN_API void jsmnreader_reset(jsmnreader_obj * reader)
+	{
+		reader->txt_size = 0;
+		reader->tokens_count = 0;
+		reader->frozen = 0;
+#ifdef JSMNR_ARRAY_INDEX
+		reader->array_elements_count = 0;
+		reader->array_ready = 0;
+#endif
+#ifdef JSMNR_PATH_CACHE
+		jsmnreader_path_invalidate(reader);
+#endif
+	}
+
+	JSMN_API void jsmnreader_shrink(jsmnreader_obj * reader)
+	{
+#ifndef JSMNR_NO_HEAP
+		jsmntok_t * tokens;
+		char * txt;
+		if (reader->tokens_capacity > reader->tokens_count)
+		{
+			tokens = (jsmntok_t *)jsmnreader_realloc(reader->tokens, (reader->tokens_count + 1) * sizeof(jsmntok_t), reader);
+			if (tokens != NULL)
+			{
+				reader->tokens = tokens;
+				reader->tokens_capacity = reader->tokens_count + 1;
+			}
+		}
+		if (reader->txt != reader->txt_buffer)
+		{
+			free(reader->txt_buffer);
+			reader->txt_buffer = NULL;
+			reader->txt_capacity = 0;
+		}
+		else if (reader->txt_capacity > reader->txt_size + 1)
+		{
+			txt = (char *)jsmnreader_realloc(reader->txt_buffer, reader->txt_size + 1, reader);
+			if (txt != NULL)
+			{
+				reader->txt = txt;
+				reader->txt_buffer = txt;
+				reader->txt_capacity = reader->txt_size + 1;
+			}
+		}
+#ifdef JSMNR_ARRAY_INDEX
+		free(reader->array_index);
+		free(reader->array_elements);
+		reader->array_index = NULL;
+		reader->array_elements = NULL;
+		reader->array_elements_count = 0;
+		reader->array_capacity = 0;
+		reader->array_ready = 0;
+#endif
+#ifdef JSMNR_PATH_CACHE
+		free(reader->path_entries);
+		free(reader->path_chars);
+		reader->path_entries = NULL;
+		reader->path_chars = NULL;
+		reader->path_chars_used = 0;
+		reader->path_chars_capacity = 0;
+		reader->path_count = 0;
+#endif
+#else
+		//The caller's buffers are already as small as they will get
+		(void)reader;
+#endif
+	}
+
+	static int jsmnreader_utf8_check(const unsigned char * s, unsigned int avail)
+	{
+		//Returns the length of the UTF-8 sequence at 's', 0 if it's invalid (overlong, surrogate, past U+10FFFF), or -1 if it runs past 'avail'
+		unsigned int n;
+		unsigned int i;
+		unsigned char lo;
+		unsigned char hi;
+		lo = 0x80;
+		hi = 0xBF;
+		if (s[0] < 0x80)
+			return 1;
+		else if (s[0] < 0xC2)
+			return 0;
+		else if (s[0] < 0xE0)
+			n = 2;
+		else if (s[0] < 0xF0)
+		{
+			n = 3;
+			if (s[0] == 0xE0)
+				lo = 0xA0;
+			if (s[0] == 0xED)
+				hi = 0x9F;
+		}
+		else if (s[0] < 0xF5)
+		{
+			n = 4;
+			if (s[0] == 0xF0)
+				lo = 0x90;
+			if (s[0] == 0xF4)
+				hi = 0x8F;
+		}
+		else
+			return 0;
+		for (i = 1; i < n; i++)
+		{
+			if (i >= avail)
+				return -1;
+			if (s[i] < lo || s[i] > hi)
+				return 0;
+			lo = 0x80;
+			hi = 0xBF;
+		}
+		return n;
+	}
 
-		reader->tokens = (jsmntok_t *)realloc(reader->tokens, (reader->tokens_count)* sizeof(jsmntok_t));
-		jsmn_init(&parser);
-		check = jsmn_parse(&parser, reader->txt, reader->txt_size, reader->tokens, reader->tokens_count, 0);
+#ifdef JSMNR_SSSE3
+	/* Error bits for the UTF-8 lookup tables, flagging a byte by the byte before it (Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte") */
+#define JSMNR_UTF8_TOO_SHORT 0x01 /* lead byte not followed by a continuation */
+#define JSMNR_UTF8_TOO_LONG 0x02 /* ASCII followed by a continuation */
+#define JSMNR_UTF8_OVERLONG_3 0x04
+#define JSMNR_UTF8_TOO_LARGE 0x08
+#define JSMNR_UTF8_SURROGATE 0x10
+#define JSMNR_UTF8_OVERLONG_2 0x20
+#define JSMNR_UTF8_TOO_LARGE_1000 0x40
+#define JSMNR_UTF8_OVERLONG_4 0x40
+#define JSMNR_UTF8_TWO_CONTS 0x80 /* continuation not part of a sequence, checked against the lead bytes 2 and 3 back */
+#define JSMNR_UTF8_CARRY (JSMNR_UTF8_TOO_SHORT | JSMNR_UTF8_TOO_LONG | JSMNR_UTF8_TWO_CONTS)
+
+	static void jsmnreader_utf8_tables(__m128i * tables)
+	{
+		//Indexed by the high nibble of the previous byte, the low nibble of the previous byte and the high nibble of this byte
+		*(tables + 0) = _mm_setr_epi8(
+			JSMNR_UTF8_TOO_LONG, JSMNR_UTF8_TOO_LONG, JSMNR_UTF8_TOO_LONG, JSMNR_UTF8_TOO_LONG,
+			JSMNR_UTF8_TOO_LONG, JSMNR_UTF8_TOO_LONG, JSMNR_UTF8_TOO_LONG, JSMNR_UTF8_TOO_LONG,
+			(char)JSMNR_UTF8_TWO_CONTS, (char)JSMNR_UTF8_TWO_CONTS, (char)JSMNR_UTF8_TWO_CONTS, (char)JSMNR_UTF8_TWO_CONTS,
+			JSMNR_UTF8_TOO_SHORT | JSMNR_UTF8_OVERLONG_2,
+			JSMNR_UTF8_TOO_SHORT,
+			JSMNR_UTF8_TOO_SHORT | JSMNR_UTF8_OVERLONG_3 | JSMNR_UTF8_SURROGATE,
+			JSMNR_UTF8_TOO_SHORT | JSMNR_UTF8_TOO_LARGE | JSMNR_UTF8_TOO_LARGE_1000 | JSMNR_UTF8_OVERLONG_4);
+		*(tables + 1) = _mm_setr_epi8(
+			(char)(JSMNR_UTF8_CARRY | JSMNR_UTF8_OVERLONG_3 | JSMNR_UTF8_OVERLONG_2 | JSMNR_UTF8_OVERLONG_4),
+			(char)(JSMNR_UTF8_CARRY | JSMNR_UTF8_OVERLONG_2),
+			(char)JSMNR_UTF8_CARRY,
+			(char)JSMNR_UTF8_CARRY,
+			(char)(JSMNR_UTF8_CARRY | JSMNR_UTF8_TOO_LARGE),
+			(char)(JSMNR_UTF8_CARRY | JSMNR_UTF8_TOO_LARGE | JSMNR_UTF8_TOO_LARGE_1000),
+			(char)(JSMNR_UTF8_CARRY | JSMNR_UTF8_TOO_LARGE | JSMNR_UTF8_TOO_LARGE_1000),
+			(char)(JSMNR_UTF8_CARRY | JSMNR_UTF8_TOO_LARGE | JSMNR_UTF8_TOO_LARGE_1000),
+			(char)(JSMNR_UTF8_CARRY | JSMNR_UTF8_TOO_LARGE | JSMNR_UTF8_TOO_LARGE_1000),
+			(char)(JSMNR_UTF8_CARRY | JSMNR_UTF8_TOO_LARGE | JSMNR_UTF8_TOO_LARGE_1000),
+			(char)(JSMNR_UTF8_CARRY | JSMNR_UTF8_TOO_LARGE | JSMNR_UTF8_TOO_LARGE_1000),
+			(char)(JSMNR_UTF8_CARRY | JSMNR_UTF8_TOO_LARGE | JSMNR_UTF8_TOO_LARGE_1000),
+			(char)(JSMNR_UTF8_CARRY | JSMNR_UTF8_TOO_LARGE | JSMNR_UTF8_TOO_LARGE_1000),
+			(char)(JSMNR_UTF8_CARRY | JSMNR_UTF8_TOO_LARGE | JSMNR_UTF8_TOO_LARGE_1000 | JSMNR_UTF8_SURROGATE),
+			(char)(JSMNR_UTF8_CARRY | JSMNR_UTF8_TOO_LARGE | JSMNR_UTF8_TOO_LARGE_1000),
+			(char)(JSMNR_UTF8_CARRY | JSMNR_UTF8_TOO_LARGE | JSMNR_UTF8_TOO_LARGE_1000));
+		*(tables + 2) = _mm_setr_epi8(
+			JSMNR_UTF8_TOO_SHORT, JSMNR_UTF8_TOO_SHORT, JSMNR_UTF8_TOO_SHORT, JSMNR_UTF8_TOO_SHORT,
+			JSMNR_UTF8_TOO_SHORT, JSMNR_UTF8_TOO_SHORT, JSMNR_UTF8_TOO_SHORT, JSMNR_UTF8_TOO_SHORT,
+			(char)(JSMNR_UTF8_TOO_LONG | JSMNR_UTF8_OVERLONG_2 | JSMNR_UTF8_TWO_CONTS | JSMNR_UTF8_OVERLONG_3 | JSMNR_UTF8_TOO_LARGE_1000 | JSMNR_UTF8_OVERLONG_4),
+			(char)(JSMNR_UTF8_TOO_LONG | JSMNR_UTF8_OVERLONG_2 | JSMNR_UTF8_TWO_CONTS | JSMNR_UTF8_OVERLONG_3 | JSMNR_UTF8_TOO_LARGE),
+			(char)(JSMNR_UTF8_TOO_LONG | JSMNR_UTF8_OVERLONG_2 | JSMNR_UTF8_TWO_CONTS | JSMNR_UTF8_SURROGATE | JSMNR_UTF8_TOO_LARGE),
+			(char)(JSMNR_UTF8_TOO_LONG | JSMNR_UTF8_OVERLONG_2 | JSMNR_UTF8_TWO_CONTS | JSMNR_UTF8_SURROGATE | JSMNR_UTF8_TOO_LARGE),
+			JSMNR_UTF8_TOO_SHORT, JSMNR_UTF8_TOO_SHORT, JSMNR_UTF8_TOO_SHORT, JSMNR_UTF8_TOO_SHORT);
+	}
+
+#ifndef JSMNR_AVX2
+	static int jsmnreader_utf8_block_ssse3(__m128i input, __m128i * prev, const __m128i * tables)
+	{
+		//Returns non-zero if the 16 bytes in 'input', following the 16 in 'prev', hold a UTF-8 error
+		__m128i prev1;
+		__m128i nibble;
+		__m128i special;
+		__m128i must_continue;
+		nibble = _mm_set1_epi8(0x0F);
+		prev1 = _mm_alignr_epi8(input, *prev, 15);
+		special = _mm_and_si128(_mm_and_si128(
+			_mm_shuffle_epi8(*(tables + 0), _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+			_mm_shuffle_epi8(*(tables + 1), _mm_and_si128(prev1, nibble))),
+			_mm_shuffle_epi8(*(tables + 2), _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+		//A byte 2 after a 3 or 4 byte lead, or 3 after a 4 byte lead, has to be a continuation
+		must_continue = _mm_or_si128(
+			_mm_subs_epu8(_mm_alignr_epi8(input, *prev, 14), _mm_set1_epi8((char)(0xE0 - 0x80))),
+			_mm_subs_epu8(_mm_alignr_epi8(input, *prev, 13), _mm_set1_epi8((char)(0xF0 - 0x80))));
+		*prev = input;
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_xor_si128(_mm_and_si128(must_continue, _mm_set1_epi8((char)0x80)), special), _mm_setzero_si128())) != 0xFFFF;
+	}
+#endif
+#endif
+
+#ifdef JSMNR_AVX2
+	static int jsmnreader_utf8_block_avx2(__m256i input, __m256i * prev, const __m256i * tables)
+	{
+		//Same as jsmnreader_utf8_block_ssse3(), 32 bytes at a time
+		__m256i shifted;
+		__m256i prev1;
+		__m256i nibble;
+		__m256i special;
+		__m256i must_continue;
+		nibble = _mm256_set1_epi8(0x0F);
+		shifted = _mm256_permute2x128_si256(*prev, input, 0x21);
+		prev1 = _mm256_alignr_epi8(input, shifted, 15);
+		special = _mm256_and_si256(_mm256_and_si256(
+			_mm256_shuffle_epi8(*(tables + 0), _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+			_mm256_shuffle_epi8(*(tables + 1), _mm256_and_si256(prev1, nibble))),
+			_mm256_shuffle_epi8(*(tables + 2), _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+		must_continue = _mm256_or_si256(
+			_mm256_subs_epu8(_mm256_alignr_epi8(input, shifted, 14), _mm256_set1_epi8((char)(0xE0 - 0x80))),
+			_mm256_subs_epu8(_mm256_alignr_epi8(input, shifted, 13), _mm256_set1_epi8((char)(0xF0 - 0x80))));
+		*prev = input;
+		return !_mm256_testz_si256(_mm256_xor_si256(_mm256_and_si256(must_continue, _mm256_set1_epi8((char)0x80)), special), _mm256_set1_epi8((char)0xFF));
+	}
+#endif
+
+	JSMN_API int jsmnreader_utf8_validate(const char * str, unsigned int str_size, unsigned int * error_pos)
+	{
+		const unsigned char * s;
+		unsigned int pos;
+		unsigned int back;
+		int n;
+		int check;
+#ifdef JSMNR_SSSE3
+		__m128i tables[3];
+		int ascii;
+		int prev_ascii;
+#endif
+#ifdef JSMNR_AVX2
+		__m256i wide_tables[3];
+		__m256i wide_input;
+		__m256i wide_prev;
+#elif defined(JSMNR_SSSE3)
+		__m128i input;
+		__m128i prev;
+#endif
+		s = (const unsigned char *)str;
+		pos = 0;
+		check = JSMN_SUCCESS;
+#ifdef JSMNR_SSSE3
+		//Checks whole blocks with table lookups, skipping runs of ASCII, and leaves the tail or the block with the error to the loop below
+		jsmnreader_utf8_tables(tables);
+		prev_ascii = 1;
+#ifdef JSMNR_AVX2
+		for (n = 0; n < 3; n++)
+			wide_tables[n] = _mm256_broadcastsi128_si256(tables[n]);
+		wide_prev = _mm256_setzero_si256();
+		while (pos + 32 <= str_size)
+		{
+			wide_input = _mm256_loadu_si256((const __m256i *)(s + pos));
+			ascii = (_mm256_movemask_epi8(wide_input) == 0);
+			if (ascii && prev_ascii)
+				wide_prev = wide_input;
+			else if (jsmnreader_utf8_block_avx2(wide_input, &wide_prev, wide_tables))
+				break;
+			prev_ascii = ascii;
+			pos += 32;
+		}
+#else
+		prev = _mm_setzero_si128();
+		while (pos + 16 <= str_size)
+		{
+			input = _mm_loadu_si128((const __m128i *)(s + pos));
+			ascii = (_mm_movemask_epi8(input) == 0);
+			if (ascii && prev_ascii)
+				prev = input;
+			else if (jsmnreader_utf8_block_ssse3(input, &prev, tables))
+				break;
+			prev_ascii = ascii;
+			pos += 16;
+		}
+#endif
+#endif
+		//Backs up to the start of a character that might run across 'pos', since the blocks can't see past their end
+		back = (pos < 3) ? pos : 3;
+		pos -= back;
+		while (back > 0 && (s[pos] & 0xC0) == 0x80)
+		{
+			pos++;
+			back--;
+		}
+		while (pos < str_size)
+		{
+#ifdef JSMNR_SSE2
+			//Skips ASCII 16 bytes at a time, only decoding around bytes with the high bit set
+			while (pos + 16 <= str_size && _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(s + pos))) == 0)
+				pos += 16;
+#endif
+			while (pos < str_size && s[pos] < 0x80)
+				pos++;
+			if (pos >= str_size)
+				break;
+			n = jsmnreader_utf8_check(s + pos, str_size - pos);
+			if (n <= 0)
+			{
+				check = (n < 0) ? JSMN_ERROR_PART : JSMN_ERROR_INVAL;
+				break;
+			}
+			pos += n;
+		}
+		if (error_pos != NULL)
+			*error_pos = pos;
+		return check;
+	}
+
+	JSMN_API unsigned int jsmnreader_token_estimate(const char * str, unsigned int str_size)
+	{
+		//Every token but the first comes straight after one of these, and the ones inside strings only make it an overestimate
+		unsigned int count;
+		unsigned int pos;
+		char c;
+#ifdef JSMNR_SSE2
+		__m128i input;
+		__m128i sums;
+		unsigned int blocks;
+#endif
+		count = 1;
+		pos = 0;
+#ifdef JSMNR_SSE2
+		//Each match takes 1 off a byte lane (compares give -1), and the lanes are added up before any can wrap
+		while (pos + 16 <= str_size)
+		{
+			sums = _mm_setzero_si128();
+			for (blocks = 0; blocks < 255 && pos + 16 <= str_size; blocks++)
+			{
+				input = _mm_loadu_si128((const __m128i *)(str + pos));
+				sums = _mm_add_epi8(sums, _mm_cmpeq_epi8(_mm_or_si128(input, _mm_set1_epi8(0x20)), _mm_set1_epi8('{')));
+				sums = _mm_add_epi8(sums, _mm_cmpeq_epi8(input, _mm_set1_epi8(',')));
+				sums = _mm_add_epi8(sums, _mm_cmpeq_epi8(input, _mm_set1_epi8(':')));
+				pos += 16;
+			}
+			sums = _mm_sad_epu8(_mm_sub_epi8(_mm_setzero_si128(), sums), _mm_setzero_si128());
+			count += _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+		}
+#endif
+		for (; pos < str_size; pos++)
+		{
+			c = str[pos];
+			if (c == '{' || c == '[' || c == ',' || c == ':')
+				count++;
+		}
+		return count;
+	}
+
+#ifndef JSMNR_NO_HEAP
+	static int jsmnreader_tokens_grow(unsigned int tokens_needed, struct jsmnreader_obj_struct * reader)
+	{
+		jsmntok_t * tokens;
+		tokens = (jsmntok_t *)jsmnreader_realloc(reader->tokens, tokens_needed * sizeof(jsmntok_t), reader);
+		if (tokens == NULL)
+			return JSMN_ERROR_NOMEM;
+		reader->tokens = tokens;
+		reader->tokens_capacity = tokens_needed;
+		return JSMN_SUCCESS;
+	}
+
+#endif
+	static int jsmnreader_tokenize(struct jsmnreader_obj_struct * reader)
+	{
+		jsmn_parser parser;
+#ifndef JSMNR_NO_HEAP
+		jsmntok_t * tokens;
+		unsigned int estimate;
+#endif
+		int check;
+		reader->tokens_count = 0;
+		reader->insitu = 0;
+		reader->frozen = 0;
+#ifdef JSMNR_ARRAY_INDEX
+		reader->array_elements_count = 0;
+		reader->array_ready = 0;
+#endif
+#ifdef JSMNR_PATH_CACHE
+		jsmnreader_path_invalidate(reader);
+#endif
+#ifdef JSMNR_UTF8_VALIDATE
+		//jsmn only lets bytes past 0x7F through inside strings, so checking the whole text checks every string token
+		if (jsmnreader_utf8_validate(reader->txt, reader->txt_size, NULL) != JSMN_SUCCESS)
+			return JSMN_ERROR_INVAL;
+#endif
+
+		//Parse straight into the tokens kept from earlier loads, growing to the estimate when they run out and only counting when that does too (never, without the heap)
+		check = JSMN_ERROR_NOMEM;
+		if (reader->tokens_capacity > 0)
+		{
+			jsmn_init(&parser);
+			check = jsmn_parse(&parser, reader->txt, reader->txt_size, reader->tokens, reader->tokens_capacity, 0);
+			JSMNR_STAT_ADD(reader, parse_passes, 1);
+			JSMNR_STAT_ADD(reader, bytes_parsed, reader->txt_size);
+		}
+#ifndef JSMNR_NO_HEAP
+		if (check == JSMN_ERROR_NOMEM)
+		{
+			estimate = jsmnreader_token_estimate(reader->txt, reader->txt_size);
+			if (estimate > reader->tokens_capacity)
+			{
+				if (jsmnreader_tokens_grow(estimate, reader) != JSMN_SUCCESS)
+					return JSMN_ERROR_NOMEM;
+				jsmn_init(&parser);
+				check = jsmn_parse(&parser, reader->txt, reader->txt_size, reader->tokens, reader->tokens_capacity, 0);
+				JSMNR_STAT_ADD(reader, parse_passes, 1);
+				JSMNR_STAT_ADD(reader, bytes_parsed, reader->txt_size);
+			}
+		}
 		if (check == JSMN_ERROR_NOMEM)
 		{
-			//if (DEBUGPRINT_FILELOAD)
-			//	printf("Not enough! (%d)", reader->tokens_count);
-			return JSMN_ERROR_NOMEM;
+			//More than one value at the top, or whitespace between primitives, can go past the estimate
+			JSMNR_STAT_ADD(reader, estimate_misses, 1);
+			jsmn_init(&parser);
+			check = jsmn_parse(&parser, reader->txt, reader->txt_size, NULL, 0, 1);
+			JSMNR_STAT_ADD(reader, parse_passes, 1);
+			JSMNR_STAT_ADD(reader, bytes_parsed, reader->txt_size);
+			if (check >= 0)
+			{
+				if ((unsigned int)check > reader->tokens_capacity && jsmnreader_tokens_grow(check, reader) != JSMN_SUCCESS)
+					return JSMN_ERROR_NOMEM;
+				jsmn_init(&parser);
+				check = jsmn_parse(&parser, reader->txt, reader->txt_size, reader->tokens, reader->tokens_capacity, 0);
+				JSMNR_STAT_ADD(reader, parse_passes, 1);
+				JSMNR_STAT_ADD(reader, bytes_parsed, reader->txt_size);
+			}
+		}
+#endif
+		//JSMN_ERROR_DEPTH, like JSMN_ERROR_INVAL and JSMN_ERROR_PART, stops at the first pass that finds it, as more tokens wouldn't help
+		if (check < 0)
+			return check;
+		reader->tokens_count = check;
+#ifndef JSMNR_NO_HEAP
+		if (reader->tokens_capacity * sizeof(jsmntok_t) > JSMNR_SHRINK_MIN && reader->tokens_capacity / JSMNR_SHRINK_RATIO > reader->tokens_count)
+		{
+			tokens = (jsmntok_t *)jsmnreader_realloc(reader->tokens, (reader->tokens_count + 1) * sizeof(jsmntok_t), reader);
+			if (tokens != NULL)
+			{
+				reader->tokens = tokens;
+				reader->tokens_capacity = reader->tokens_count + 1;
+			}
+		}
+#endif
+		JSMNR_STAT_ADD(reader, tokens_emitted, reader->tokens_count);
+		return JSMN_SUCCESS;
+	}
+
+	static int jsmnreader_buffer_fit(unsigned int txt_needed, struct jsmnreader_obj_struct * reader)
+	{
+		//Grows the reader's own text buffer, or gives it back when it's far bigger than needed
+#ifdef JSMNR_NO_HEAP
+		return (txt_needed <= reader->txt_capacity);
+#else
+		char * txt;
+		if (txt_needed > reader->txt_capacity || (reader->txt_capacity > JSMNR_SHRINK_MIN && reader->txt_capacity / JSMNR_SHRINK_RATIO > txt_needed))
+		{
+			txt = (char *)jsmnreader_realloc(reader->txt_buffer, sizeof(char) * txt_needed, reader);
+			if (txt == NULL)
+				return 0;
+			if (reader->txt == reader->txt_buffer)
+				reader->txt = txt;
+			reader->txt_buffer = txt;
+			reader->txt_capacity = txt_needed;
+		}
+		return 1;
+#endif
+	}
+
+	JSMN_API int jsmnreader_load(char * str, unsigned int str_size, struct jsmnreader_obj_struct * reader)
+	{
+		return jsmnreader_load_mode(str, str_size, JSMNR_LOAD_OWN, reader);
+	}
+
+	JSMN_API int jsmnreader_load_mode(char * str, unsigned int str_size, jsmnreaderload_t mode, struct jsmnreader_obj_struct * reader)
+	{
+		int check;
+#ifdef JSMNR_SPANS
+		jsmnreader_trace span;
+#endif
+#ifdef JSMNR_SIDECAR
+		jsmnreader_unmap(reader);
+#endif
+		switch (mode)
+		{
+		case JSMNR_LOAD_OWN:
+			//Without the heap there's nothing to free it with, so it's only borrowed
+#ifndef JSMNR_NO_HEAP
+			if (str != reader->txt_buffer)
+			{
+				free(reader->txt_buffer);
+				reader->txt_buffer = str;
+				reader->txt_capacity = str_size;
+			}
+			reader->txt = str;
+			break;
+#endif
+		case JSMNR_LOAD_BORROW:
+			reader->txt = str;
+			break;
+		case JSMNR_LOAD_COPY:
+			if (str != reader->txt_buffer)
+			{
+				if (!jsmnreader_buffer_fit(str_size + 1, reader))
+				{
+					reader->txt_size = 0;
+					reader->tokens_count = 0;
+					return JSMN_ERROR_NOMEM;
+				}
+				memcpy(reader->txt_buffer, str, str_size);
+				*(reader->txt_buffer + str_size) = '\0';
+			}
+			reader->txt = reader->txt_buffer;
+			break;
+		}
+		reader->txt_size = str_size;
+#ifdef JSMNR_SPANS
+		jsmnreader_span_begin(&span, JSMNR_TRACE_LOAD, NULL, 0, reader);
+#endif
+		check = jsmnreader_tokenize(reader);
+#ifdef JSMNR_SPANS
+		jsmnreader_span_end(&span, check, reader);
+#endif
+		return check;
+	}
+
+	static int jsmnreader_fileread(char * filepath, struct jsmnreader_obj_struct * reader)
+	{
+		FILE * str_file;
+		unsigned int txt_needed;
+#ifdef JSMNR_SIDECAR
+		jsmnreader_unmap(reader);
+#endif
+		reader->txt_size = 0;
+		reader->tokens_count = 0;
+		str_file = fopen(filepath, "rb");
+		if (!str_file)
+		{
+			return JSMN_ERROR_NOFILE;
+		}
+		fseek(str_file, 0, SEEK_END); txt_needed = ftell(str_file) + 1; fseek(str_file, 0, SEEK_SET);
+		if (!jsmnreader_buffer_fit(txt_needed, reader))
+		{
+			fclose(str_file);
+			return JSMN_ERROR_NOMEM;
+		}
+		reader->txt_size = fread(reader->txt_buffer, 1, txt_needed - 1, str_file);
+		*(reader->txt_buffer + (reader->txt_size)) = '\0';
+		fclose(str_file);
+
+		return jsmnreader_load_mode(reader->txt_buffer, reader->txt_size, JSMNR_LOAD_OWN, reader);
+	}
+
+	JSMN_API int jsmnreader_fileload(char * filepath, struct jsmnreader_obj_struct * reader)
+	{
+		int check;
+#ifdef JSMNR_SPANS
+		jsmnreader_trace span;
+		jsmnreader_span_begin(&span, JSMNR_TRACE_FILELOAD, filepath, 0, reader);
+#endif
+		check = jsmnreader_fileread(filepath, reader);
+#ifdef JSMNR_SPANS
+		jsmnreader_span_end(&span, check, reader);
+#endif
+		return check;
+	}
+
+#ifdef JSMNR_SIDECAR
+#define JSMNR_SIDECAR_VERSION 2
+#define JSMNR_SIDECAR_BYTE_ORDER 0x01020304u
+
+	/* Start of a sidecar index file, followed by the tokens exactly as they sit in memory */
+	typedef struct jsmnreader_sidecar_struct
+	{
+		char magic[8]; /* "JSMNRIDX" */
+		unsigned int version;
+		unsigned int token_size; /* sizeof(jsmntok_t), which JSMN_PARENT_LINKS changes */
+		unsigned int byte_order; /* JSMNR_SIDECAR_BYTE_ORDER, as read back on the machine that wrote it */
+		unsigned int tokens_count;
+		unsigned long long source_size;
+		unsigned long long source_mtime;
+		unsigned long long source_dev;
+		unsigned long long source_inode;
+		unsigned long long source_hash; /* Always written, only checked with JSMNR_SIDECAR_HASH */
+	} jsmnreader_sidecar;
+
+	static void jsmnreader_sidecar_header(jsmnreader_sidecar * header, const struct stat * source, const char * txt, unsigned int tokens_count)
+	{
+		memset(header, 0, sizeof(jsmnreader_sidecar));
+		memcpy(header->magic, "JSMNRIDX", 8);
+		header->version = JSMNR_SIDECAR_VERSION;
+		header->token_size = sizeof(jsmntok_t);
+		header->byte_order = JSMNR_SIDECAR_BYTE_ORDER;
+		header->tokens_count = tokens_count;
+		header->source_size = (unsigned long long)source->st_size;
+		header->source_mtime = (unsigned long long)source->st_mtime;
+		header->source_dev = (unsigned long long)source->st_dev;
+		header->source_inode = (unsigned long long)source->st_ino;
+		header->source_hash = (txt != NULL) ? jsmnreader_hash(txt, (size_t)source->st_size) : 0;
+	}
+
+	static int jsmnreader_sidecar_tokens(const jsmntok_t * tokens, unsigned int tokens_count, unsigned int txt_size)
+	{
+		//The getters trust a token's positions and size, so an index that was damaged or written over has to be caught before it's used
+		unsigned int i;
+		for (i = 0; i < tokens_count; i++)
+		{
+			if ((tokens + i)->type != JSMN_OBJECT && (tokens + i)->type != JSMN_ARRAY && (tokens + i)->type != JSMN_STRING && (tokens + i)->type != JSMN_PRIMITIVE)
+				return 0;
+			if ((tokens + i)->start < 0 || (tokens + i)->start > (tokens + i)->end || (unsigned int)(tokens + i)->end > txt_size)
+				return 0;
+			//A string's closing quote is read past its end
+			if ((tokens + i)->type == JSMN_STRING && (unsigned int)(tokens + i)->end == txt_size)
+				return 0;
+			if ((tokens + i)->size < 0 || (unsigned int)(tokens + i)->size >= tokens_count)
+				return 0;
+#ifdef JSMN_PARENT_LINKS
+			if ((tokens + i)->parent < -1 || (tokens + i)->parent >= (int)i)
+				return 0;
+#endif
+		}
+		return 1;
+	}
+
+	static int jsmnreader_sidecar_map(char * filepath, char * sidecar_path, struct jsmnreader_obj_struct * reader)
+	{
+		int source_fd;
+		int index_fd;
+		struct stat source;
+		struct stat index;
+		jsmnreader_sidecar header;
+		jsmnreader_sidecar expected;
+		char * map_index;
+		char * map_txt;
+		int check;
+		source_fd = open(filepath, O_RDONLY);
+		if (source_fd < 0)
+			return JSMN_ERROR_NOFILE;
+		index_fd = open(sidecar_path, O_RDONLY);
+		if (index_fd < 0)
+		{
+			close(source_fd);
+			return JSMN_ERROR_NOFILE;
+		}
+		check = JSMN_ERROR_INVAL;
+		map_index = (char *)MAP_FAILED;
+		map_txt = (char *)MAP_FAILED;
+		if (fstat(source_fd, &source) == 0 && source.st_size > 0 && fstat(index_fd, &index) == 0 && read(index_fd, &header, sizeof(header)) == (ssize_t)sizeof(header))
+		{
+			jsmnreader_sidecar_header(&expected, &source, NULL, header.tokens_count);
+			expected.source_hash = header.source_hash;
+			if (memcmp(&header, &expected, sizeof(header)) == 0 && (unsigned long long)index.st_size == sizeof(header) + (unsigned long long)header.tokens_count * sizeof(jsmntok_t))
+			{
+				//Both are private and writable, so jsmnreader_insitu() only writes over the reader's own copy of the pages it touches
+				check = JSMN_ERROR_NOMEM;
+				map_index = (char *)mmap(NULL, (size_t)index.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, index_fd, 0);
+				if (map_index != (char *)MAP_FAILED)
+					map_txt = (char *)mmap(NULL, (size_t)source.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, source_fd, 0);
+				if (map_txt != (char *)MAP_FAILED)
+					check = jsmnreader_sidecar_tokens((const jsmntok_t *)(map_index + sizeof(header)), header.tokens_count, (unsigned int)source.st_size) ? JSMN_SUCCESS : JSMN_ERROR_INVAL;
+#ifdef JSMNR_SIDECAR_HASH
+				//Reads the whole file, for when it can be rewritten in place within the same second at the same size
+				if (check == JSMN_SUCCESS && jsmnreader_hash(map_txt, (size_t)source.st_size) != header.source_hash)
+					check = JSMN_ERROR_INVAL;
+#endif
+			}
+		}
+		close(index_fd);
+		close(source_fd);
+		if (check != JSMN_SUCCESS)
+		{
+			if (map_txt != (char *)MAP_FAILED)
+				munmap(map_txt, (size_t)source.st_size);
+			if (map_index != (char *)MAP_FAILED)
+				munmap(map_index, (size_t)index.st_size);
+			return check;
+		}
+
+		free(reader->tokens);
+		reader->tokens = (jsmntok_t *)(map_index + sizeof(header));
+		reader->tokens_count = header.tokens_count;
+		reader->tokens_capacity = 0;
+		reader->txt = map_txt;
+		reader->txt_size = (unsigned int)source.st_size;
+		reader->insitu = 0;
+		reader->frozen = 0;
+		reader->map_index = map_index;
+		reader->map_index_size = (size_t)index.st_size;
+		reader->map_txt = map_txt;
+		reader->map_txt_size = (size_t)source.st_size;
+#ifdef JSMNR_ARRAY_INDEX
+		reader->array_elements_count = 0;
+		reader->array_ready = 0;
+#endif
+#ifdef JSMNR_PATH_CACHE
+		jsmnreader_path_invalidate(reader);
+#endif
+		JSMNR_STAT_ADD(reader, sidecar_loads, 1);
+		return JSMN_SUCCESS;
+	}
+
+	static void jsmnreader_sidecar_write(char * filepath, char * sidecar_path, struct jsmnreader_obj_struct * reader)
+	{
+		//Written under a name of its own and renamed over, so nobody maps a half written index
+		struct stat source;
+		jsmnreader_sidecar header;
+		FILE * index_file;
+		char * tmp_path;
+		int written;
+		if (stat(filepath, &source) != 0 || (unsigned long long)source.st_size != reader->txt_size || reader->txt_size == 0)
+			return;
+		tmp_path = (char *)jsmnreader_malloc(strlen(sidecar_path) + 32, reader);
+		if (tmp_path == NULL)
+			return;
+		sprintf(tmp_path, "%s.%ld.tmp", sidecar_path, (long)getpid());
+		index_file = fopen(tmp_path, "wb");
+		if (index_file != NULL)
+		{
+			jsmnreader_sidecar_header(&header, &source, reader->txt, reader->tokens_count);
+			written = (fwrite(&header, sizeof(header), 1, index_file) == 1
+				&& fwrite(reader->tokens, sizeof(jsmntok_t), reader->tokens_count, index_file) == reader->tokens_count);
+			if (fclose(index_file) != 0 || !written || rename(tmp_path, sidecar_path) != 0)
+				remove(tmp_path);
+		}
+		free(tmp_path);
+	}
+
+	JSMN_API int jsmnreader_fileload_sidecar(char * filepath, char * sidecar_path, struct jsmnreader_obj_struct * reader)
+	{
+		char * index_path;
+		int check;
+#ifdef JSMNR_SPANS
+		jsmnreader_trace span;
+#endif
+		jsmnreader_unmap(reader);
+		reader->txt_size = 0;
+		reader->tokens_count = 0;
+#ifdef JSMNR_SPANS
+		jsmnreader_span_begin(&span, JSMNR_TRACE_FILELOAD, filepath, 0, reader);
+#endif
+		index_path = sidecar_path;
+		if (index_path == NULL)
+		{
+			index_path = (char *)jsmnreader_malloc(strlen(filepath) + 7, reader);
+			if (index_path == NULL)
+			{
+#ifdef JSMNR_SPANS
+				jsmnreader_span_end(&span, JSMN_ERROR_NOMEM, reader);
+#endif
+				return JSMN_ERROR_NOMEM;
+			}
+			strcpy(index_path, filepath);
+			strcat(index_path, ".jsmnr");
+		}
+		check = jsmnreader_sidecar_map(filepath, index_path, reader);
+		if (check != JSMN_SUCCESS)
+		{
+			check = jsmnreader_fileread(filepath, reader);
+			if (check == JSMN_SUCCESS)
+				jsmnreader_sidecar_write(filepath, index_path, reader);
+		}
+		if (index_path != sidecar_path)
+			free(index_path);
+#ifdef JSMNR_SPANS
+		jsmnreader_span_end(&span, check, reader);
+#endif
+		return check;
+	}
+#endif
+
+#ifdef JSMNR_CACHE
+	/* A cached document, its reader first so the reader's address leads back to it */
+	typedef struct jsmnreader_cache_entry_struct
+	{
+		jsmnreader_obj reader;
+		char * path;
+		unsigned long long hash; /* of the path, for finding it in the slots */
+		dev_t dev;
+		ino_t ino;
+		off_t size;
+		time_t mtime;
+		size_t bytes;
+		unsigned int refs; /* Readers handed out and not released yet */
+		int dropped; /* Taken out of the list while still held, freed on its last release */
+		struct jsmnreader_cache_entry_struct * prev;
+		struct jsmnreader_cache_entry_struct * next;
+	} jsmnreader_cache_entry;
+
+	/* Most recently used first */
+	static jsmnreader_cache_entry * jsmnreader_cache_head = NULL;
+	static jsmnreader_cache_entry * jsmnreader_cache_tail = NULL;
+	static jsmnreader_cache_stats jsmnreader_cache_counters = { 0, 0, 0, 0, 0, JSMNR_CACHE_BUDGET };
+	static pthread_mutex_t jsmnreader_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+	/* Open addressing index of the listed entries by path, a power of two kept at most half full */
+	static jsmnreader_cache_entry ** jsmnreader_cache_slots = NULL;
+	static unsigned int jsmnreader_cache_slots_count = 0;
+
+	static jsmnreader_cache_entry * jsmnreader_cache_find(const char * filepath, unsigned long long hash)
+	{
+		jsmnreader_cache_entry * entry;
+		unsigned int slot;
+		if (jsmnreader_cache_slots == NULL)
+			return NULL;
+		slot = (unsigned int)hash & (jsmnreader_cache_slots_count - 1);
+		while ((entry = jsmnreader_cache_slots[slot]) != NULL)
+		{
+			if (entry->hash == hash && strcmp(entry->path, filepath) == 0)
+				return entry;
+			slot = (slot + 1) & (jsmnreader_cache_slots_count - 1);
+		}
+		return NULL;
+	}
+
+	static int jsmnreader_cache_index(jsmnreader_cache_entry * entry)
+	{
+		jsmnreader_cache_entry ** slots;
+		unsigned int count;
+		unsigned int slot;
+		unsigned int i;
+		//Called before the entry is pushed, so the entries counter doesn't include it yet
+		if ((jsmnreader_cache_counters.entries + 1) * 2 > jsmnreader_cache_slots_count)
+		{
+			count = (jsmnreader_cache_slots_count == 0) ? 16 : jsmnreader_cache_slots_count * 2;
+			slots = (jsmnreader_cache_entry **)calloc(count, sizeof(jsmnreader_cache_entry *));
+			if (slots == NULL)
+				return JSMN_ERROR_NOMEM;
+			for (i = 0; i < jsmnreader_cache_slots_count; i++)
+			{
+				if (jsmnreader_cache_slots[i] == NULL)
+					continue;
+				slot = (unsigned int)jsmnreader_cache_slots[i]->hash & (count - 1);
+				while (slots[slot] != NULL)
+					slot = (slot + 1) & (count - 1);
+				slots[slot] = jsmnreader_cache_slots[i];
+			}
+			free(jsmnreader_cache_slots);
+			jsmnreader_cache_slots = slots;
+			jsmnreader_cache_slots_count = count;
+		}
+		slot = (unsigned int)entry->hash & (jsmnreader_cache_slots_count - 1);
+		while (jsmnreader_cache_slots[slot] != NULL)
+			slot = (slot + 1) & (jsmnreader_cache_slots_count - 1);
+		jsmnreader_cache_slots[slot] = entry;
+		return JSMN_SUCCESS;
+	}
+
+	static void jsmnreader_cache_unindex(jsmnreader_cache_entry * entry)
+	{
+		unsigned int mask;
+		unsigned int slot;
+		unsigned int next;
+		unsigned int home;
+		mask = jsmnreader_cache_slots_count - 1;
+		slot = (unsigned int)entry->hash & mask;
+		while (jsmnreader_cache_slots[slot] != entry)
+			slot = (slot + 1) & mask;
+		jsmnreader_cache_slots[slot] = NULL;
+		//Shifts the rest of the run back instead of leaving a tombstone, so lookups never walk past removed entries
+		next = slot;
+		while (1)
+		{
+			next = (next + 1) & mask;
+			if (jsmnreader_cache_slots[next] == NULL)
+				break;
+			home = (unsigned int)jsmnreader_cache_slots[next]->hash & mask;
+			if (((next - home) & mask) >= ((next - slot) & mask))
+			{
+				jsmnreader_cache_slots[slot] = jsmnreader_cache_slots[next];
+				jsmnreader_cache_slots[next] = NULL;
+				slot = next;
+			}
+		}
+	}
+
+	static void jsmnreader_cache_unlink(jsmnreader_cache_entry * entry)
+	{
+		if (entry->prev != NULL)
+			entry->prev->next = entry->next;
+		else
+			jsmnreader_cache_head = entry->next;
+		if (entry->next != NULL)
+			entry->next->prev = entry->prev;
+		else
+			jsmnreader_cache_tail = entry->prev;
+		entry->prev = NULL;
+		entry->next = NULL;
+		jsmnreader_cache_counters.entries--;
+		jsmnreader_cache_counters.bytes -= entry->bytes;
+	}
+
+	static void jsmnreader_cache_push(jsmnreader_cache_entry * entry)
+	{
+		entry->prev = NULL;
+		entry->next = jsmnreader_cache_head;
+		if (jsmnreader_cache_head != NULL)
+			jsmnreader_cache_head->prev = entry;
+		else
+			jsmnreader_cache_tail = entry;
+		jsmnreader_cache_head = entry;
+		jsmnreader_cache_counters.entries++;
+		jsmnreader_cache_counters.bytes += entry->bytes;
+	}
+
+	static void jsmnreader_cache_destroy(jsmnreader_cache_entry * entry)
+	{
+		jsmnreader_free(&entry->reader);
+		free(entry->path);
+		free(entry);
+	}
+
+	static void jsmnreader_cache_drop(jsmnreader_cache_entry * entry)
+	{
+		//Held documents leave the list now, but stay alive for whoever holds them
+		jsmnreader_cache_unindex(entry);
+		jsmnreader_cache_unlink(entry);
+		if (entry->refs == 0)
+			jsmnreader_cache_destroy(entry);
+		else
+			entry->dropped = 1;
+	}
+
+	static void jsmnreader_cache_evict(void)
+	{
+		//Called with the lock held, from the least recently used end
+		jsmnreader_cache_entry * entry;
+		jsmnreader_cache_entry * prev;
+		entry = jsmnreader_cache_tail;
+		while (entry != NULL && jsmnreader_cache_counters.bytes > jsmnreader_cache_counters.budget)
+		{
+			prev = entry->prev;
+			if (entry->refs == 0)
+			{
+				jsmnreader_cache_drop(entry);
+				jsmnreader_cache_counters.evictions++;
+			}
+			entry = prev;
+		}
+	}
+
+	JSMN_API jsmnreader_obj * jsmnreader_cache_fileload(const char * filepath, int * error)
+	{
+		struct stat file;
+		jsmnreader_cache_entry * entry;
+		jsmnreader_cache_entry * loaded;
+		unsigned long long hash;
+		int check;
+		if (stat(filepath, &file) != 0)
+		{
+			if (error != NULL)
+				*error = JSMN_ERROR_NOFILE;
+			return NULL;
+		}
+		hash = jsmnreader_hash(filepath, strlen(filepath));
+		pthread_mutex_lock(&jsmnreader_cache_lock);
+		entry = jsmnreader_cache_find(filepath, hash);
+		if (entry != NULL)
+		{
+			if (entry->dev == file.st_dev && entry->ino == file.st_ino && entry->size == file.st_size && entry->mtime == file.st_mtime)
+			{
+				entry->refs++;
+				if (entry != jsmnreader_cache_head)
+				{
+					jsmnreader_cache_unlink(entry);
+					jsmnreader_cache_push(entry);
+				}
+				jsmnreader_cache_counters.hits++;
+				pthread_mutex_unlock(&jsmnreader_cache_lock);
+				if (error != NULL)
+					*error = JSMN_SUCCESS;
+				return &entry->reader;
+			}
+			jsmnreader_cache_drop(entry);
+		}
+		jsmnreader_cache_counters.misses++;
+		pthread_mutex_unlock(&jsmnreader_cache_lock);
+
+		//Loaded without the lock, so other files stay available meanwhile
+		loaded = (jsmnreader_cache_entry *)malloc(sizeof(jsmnreader_cache_entry));
+		if (loaded == NULL)
+		{
+			if (error != NULL)
+				*error = JSMN_ERROR_NOMEM;
+			return NULL;
+		}
+		jsmnreader_init(&loaded->reader);
+		loaded->path = (char *)malloc(strlen(filepath) + 1);
+		check = (loaded->path != NULL) ? jsmnreader_fileload((char *)filepath, &loaded->reader) : JSMN_ERROR_NOMEM;
+		if (error != NULL)
+			*error = check;
+		if (check != JSMN_SUCCESS)
+		{
+			jsmnreader_cache_destroy(loaded);
+			return NULL;
+		}
+		jsmnreader_shrink(&loaded->reader);
+		jsmnreader_freeze(&loaded->reader);
+		strcpy(loaded->path, filepath);
+		loaded->hash = hash;
+		//Identified by the stat() from before reading, so a file changed while read is loaded again next time
+		loaded->dev = file.st_dev;
+		loaded->ino = file.st_ino;
+		loaded->size = file.st_size;
+		loaded->mtime = file.st_mtime;
+		loaded->bytes = sizeof(jsmnreader_cache_entry) + strlen(filepath) + 1 + loaded->reader.txt_capacity + loaded->reader.tokens_capacity * sizeof(jsmntok_t);
+		loaded->refs = 1;
+		loaded->dropped = 0;
+
+		pthread_mutex_lock(&jsmnreader_cache_lock);
+		//Another thread may have loaded the same path in the meantime, the newer load wins
+		entry = jsmnreader_cache_find(filepath, hash);
+		if (entry != NULL)
+			jsmnreader_cache_drop(entry);
+		if (jsmnreader_cache_index(loaded) != JSMN_SUCCESS)
+		{
+			pthread_mutex_unlock(&jsmnreader_cache_lock);
+			jsmnreader_cache_destroy(loaded);
+			if (error != NULL)
+				*error = JSMN_ERROR_NOMEM;
+			return NULL;
+		}
+		jsmnreader_cache_push(loaded);
+		jsmnreader_cache_evict();
+		pthread_mutex_unlock(&jsmnreader_cache_lock);
+		return &loaded->reader;
+	}
+
+	JSMN_API void jsmnreader_cache_release(jsmnreader_obj * reader)
+	{
+		jsmnreader_cache_entry * entry;
+		if (reader == NULL)
+			return;
+		entry = (jsmnreader_cache_entry *)reader;
+		pthread_mutex_lock(&jsmnreader_cache_lock);
+		entry->refs--;
+		if (entry->refs == 0)
+		{
+			if (entry->dropped)
+				jsmnreader_cache_destroy(entry);
+			else
+				jsmnreader_cache_evict();
+		}
+		pthread_mutex_unlock(&jsmnreader_cache_lock);
+	}
+
+	JSMN_API void jsmnreader_cache_budget(size_t bytes)
+	{
+		pthread_mutex_lock(&jsmnreader_cache_lock);
+		jsmnreader_cache_counters.budget = bytes;
+		jsmnreader_cache_evict();
+		pthread_mutex_unlock(&jsmnreader_cache_lock);
+	}
+
+	JSMN_API void jsmnreader_cache_clear(void)
+	{
+		jsmnreader_cache_entry * entry;
+		jsmnreader_cache_entry * next;
+		pthread_mutex_lock(&jsmnreader_cache_lock);
+		for (entry = jsmnreader_cache_head; entry != NULL; entry = next)
+		{
+			next = entry->next;
+			if (entry->refs == 0)
+				jsmnreader_cache_drop(entry);
+		}
+		if (jsmnreader_cache_head == NULL)
+		{
+			free(jsmnreader_cache_slots);
+			jsmnreader_cache_slots = NULL;
+			jsmnreader_cache_slots_count = 0;
+		}
+		pthread_mutex_unlock(&jsmnreader_cache_lock);
+	}
+
+	JSMN_API void jsmnreader_cache_stats_get(jsmnreader_cache_stats * stats)
+	{
+		pthread_mutex_lock(&jsmnreader_cache_lock);
+		*stats = jsmnreader_cache_counters;
+		pthread_mutex_unlock(&jsmnreader_cache_lock);
+	}
+#endif
+
+#ifdef JSMNR_BATCH
+	static int jsmnreader_batch_doc(unsigned int doc, jsmnreader_batch * batch, jsmnreader_obj * reader)
+	{
+		jsmnreader_batch_column * column;
+		unsigned int c;
+		unsigned int loc;
+		int check;
+		int found;
+		char * slot;
+		//Borrowed, so the reader never copies or frees the document, and only grows its tokens for a bigger one
+		check = jsmnreader_load_mode(batch->docs[doc], batch->docs_size[doc], JSMNR_LOAD_BORROW, reader);
+		if (batch->status != NULL)
+			batch->status[doc] = check;
+		for (c = 0; c < batch->columns_count; c++)
+		{
+			column = batch->columns + c;
+			loc = (check == JSMN_SUCCESS) ? jsmnreader_tree_get_x(column->path, 0, reader) : (unsigned int)-1;
+			found = 0;
+			if (loc != (unsigned int)-1)
+			{
+				if ((reader->tokens + loc)->type == JSMN_PRIMITIVE)
+					found = 1;
+				else if ((reader->tokens + loc)->type == JSMN_STRING && column->type == JSMNR_BATCH_STRING)
+					found = 1;
+			}
+			switch (column->type)
+			{
+			case JSMNR_BATCH_INT:
+				((int *)column->values)[doc] = found ? jsmnreader_token_get_int(loc, reader) : 0;
+				break;
+			case JSMNR_BATCH_UINT:
+				((unsigned int *)column->values)[doc] = found ? jsmnreader_token_get_uint(loc, reader) : 0;
+				break;
+			case JSMNR_BATCH_FLOAT:
+				((float *)column->values)[doc] = found ? jsmnreader_token_get_float(loc, reader) : 0;
+				break;
+			case JSMNR_BATCH_STRING:
+				slot = (char *)column->values + (size_t)doc * column->string_size;
+				if (found)
+					jsmnreader_token_copy_string(loc, slot, column->string_size, reader);
+				else if (column->string_size > 0)
+					*slot = '\0';
+				break;
+			}
+			if (column->found != NULL)
+				column->found[doc] = (unsigned char)found;
+		}
+		return (check == JSMN_SUCCESS);
+	}
+
+	static void jsmnreader_batch_work(jsmnreader_batch_worker * worker)
+	{
+		//Takes JSMNR_BATCH_CHUNK documents at a time until none are left
+		jsmnreader_batch * batch;
+		unsigned int first;
+		unsigned int last;
+		unsigned int doc;
+		unsigned int loaded;
+		batch = worker->batch;
+		loaded = 0;
+		while (1)
+		{
+			pthread_mutex_lock(&batch->lock);
+			first = batch->next;
+			last = (batch->docs_count - first > JSMNR_BATCH_CHUNK) ? first + JSMNR_BATCH_CHUNK : batch->docs_count;
+			batch->next = last;
+			if (first == last)
+				batch->loaded += loaded;
+			pthread_mutex_unlock(&batch->lock);
+			if (first == last)
+				break;
+			for (doc = first; doc < last; doc++)
+				loaded += jsmnreader_batch_doc(doc, batch, &worker->reader);
+		}
+	}
+
+	static void * jsmnreader_batch_thread(void * arg)
+	{
+		jsmnreader_batch_worker * worker;
+		jsmnreader_batch * batch;
+		unsigned int seen;
+		worker = (jsmnreader_batch_worker *)arg;
+		batch = worker->batch;
+		//Started by jsmnreader_batch_init(), before any run moved the generation on
+		seen = 0;
+		pthread_mutex_lock(&batch->lock);
+		while (1)
+		{
+			while (!batch->stop && batch->generation == seen)
+				pthread_cond_wait(&batch->start, &batch->lock);
+			if (batch->stop)
+				break;
+			seen = batch->generation;
+			pthread_mutex_unlock(&batch->lock);
+			jsmnreader_batch_work(worker);
+			pthread_mutex_lock(&batch->lock);
+			batch->running--;
+			if (batch->running == 0)
+				pthread_cond_signal(&batch->done);
+		}
+		pthread_mutex_unlock(&batch->lock);
+		return NULL;
+	}
+
+	JSMN_API int jsmnreader_batch_init(jsmnreader_batch_column * columns, unsigned int columns_count, unsigned int threads, jsmnreader_batch * batch)
+	{
+		long cpus;
+		unsigned int i;
+		if (threads == 0)
+		{
+			cpus = sysconf(_SC_NPROCESSORS_ONLN);
+			threads = (cpus > 0) ? (unsigned int)cpus : 1;
+		}
+		batch->columns = columns;
+		batch->columns_count = columns_count;
+		batch->workers = (jsmnreader_batch_worker *)malloc(threads * sizeof(jsmnreader_batch_worker));
+		batch->workers_count = 0;
+		if (batch->workers == NULL)
+			return JSMN_ERROR_NOMEM;
+		pthread_mutex_init(&batch->lock, NULL);
+		pthread_cond_init(&batch->start, NULL);
+		pthread_cond_init(&batch->done, NULL);
+		batch->generation = 0;
+		batch->running = 0;
+		batch->stop = 0;
+		batch->docs = NULL;
+		batch->docs_size = NULL;
+		batch->docs_count = 0;
+		batch->status = NULL;
+		batch->next = 0;
+		batch->loaded = 0;
+		for (i = 0; i < threads; i++)
+		{
+			(batch->workers + i)->batch = batch;
+			jsmnreader_init(&(batch->workers + i)->reader);
+			if (i > 0 && pthread_create(&(batch->workers + i)->thread, NULL, jsmnreader_batch_thread, batch->workers + i) != 0)
+			{
+				//Stops and joins the threads started so far
+				jsmnreader_batch_free(batch);
+				return JSMN_ERROR_NOMEM;
+			}
+			batch->workers_count++;
+		}
+		return JSMN_SUCCESS;
+	}
+
+	JSMN_API unsigned int jsmnreader_batch_run(char ** docs, const unsigned int * docs_size, unsigned int docs_count, int * status, jsmnreader_batch * batch)
+	{
+		pthread_mutex_lock(&batch->lock);
+		batch->docs = docs;
+		batch->docs_size = docs_size;
+		batch->docs_count = docs_count;
+		batch->status = status;
+		batch->next = 0;
+		batch->loaded = 0;
+		batch->running = batch->workers_count - 1;
+		batch->generation++;
+		pthread_cond_broadcast(&batch->start);
+		pthread_mutex_unlock(&batch->lock);
+		jsmnreader_batch_work(batch->workers);
+		pthread_mutex_lock(&batch->lock);
+		while (batch->running > 0)
+			pthread_cond_wait(&batch->done, &batch->lock);
+		pthread_mutex_unlock(&batch->lock);
+		return batch->loaded;
+	}
+
+	JSMN_API void jsmnreader_batch_free(jsmnreader_batch * batch)
+	{
+		unsigned int i;
+		if (batch->workers == NULL)
+			return;
+		pthread_mutex_lock(&batch->lock);
+		batch->stop = 1;
+		pthread_cond_broadcast(&batch->start);
+		pthread_mutex_unlock(&batch->lock);
+		for (i = 0; i < batch->workers_count; i++)
+		{
+			if (i > 0)
+				pthread_join((batch->workers + i)->thread, NULL);
+			jsmnreader_free(&(batch->workers + i)->reader);
+		}
+		pthread_cond_destroy(&batch->done);
+		pthread_cond_destroy(&batch->start);
+		pthread_mutex_destroy(&batch->lock);
+		free(batch->workers);
+		batch->workers = NULL;
+		batch->workers_count = 0;
+	}
+#endif
+
+	static unsigned int jsmnreader_validate_space(const unsigned char * s, unsigned int len, unsigned int pos)
+	{
+		while (pos < len && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\n' || s[pos] == '\r'))
+			pos++;
+		return pos;
+	}
+
+	static int jsmnreader_validate_string(const unsigned char * s, unsigned int len, unsigned int * pos)
+	{
+		unsigned int i;
+		int n;
+#ifdef JSMNR_SSE2
+		__m128i chunk;
+		int mask;
+#endif
+		(*pos)++;
+		while (1)
+		{
+#ifdef JSMNR_SSE2
+			//Skips 16 bytes at a time up to a quote, backslash, control character or non-ASCII byte (negative when signed)
+			while (*pos + 16 <= len)
+			{
+				chunk = _mm_loadu_si128((const __m128i *)(s + *pos));
+				mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))), _mm_cmplt_epi8(chunk, _mm_set1_epi8(' '))));
+				if (mask != 0)
+				{
+					*pos += __builtin_ctz(mask);
+					break;
+				}
+				*pos += 16;
+			}
+#endif
+			if (*pos >= len)
+				return JSMN_ERROR_PART;
+			if (s[*pos] == '"')
+			{
+				(*pos)++;
+				return JSMN_SUCCESS;
+			}
+			else if (s[*pos] == '\\')
+			{
+				if (*pos + 1 >= len)
+					return JSMN_ERROR_PART;
+				switch (s[*pos + 1])
+				{
+				case '"':
+				case '\\':
+				case '/':
+				case 'b':
+				case 'f':
+				case 'n':
+				case 'r':
+				case 't':
+					*pos += 2;
+					break;
+				case 'u':
+					*pos += 2;
+					for (i = 0; i < 4; i++)
+					{
+						if (*pos >= len)
+							return JSMN_ERROR_PART;
+						if (!((s[*pos] >= '0' && s[*pos] <= '9') || (s[*pos] >= 'A' && s[*pos] <= 'F') || (s[*pos] >= 'a' && s[*pos] <= 'f')))
+							return JSMN_ERROR_INVAL;
+						(*pos)++;
+					}
+					break;
+				default:
+					(*pos)++;
+					return JSMN_ERROR_INVAL;
+				}
+			}
+			else if (s[*pos] < 0x20)
+				return JSMN_ERROR_INVAL;
+			else if (s[*pos] < 0x80)
+				(*pos)++;
+			else
+			{
+				n = jsmnreader_utf8_check(s + *pos, len - *pos);
+				if (n < 0)
+					return JSMN_ERROR_PART;
+				if (n == 0)
+					return JSMN_ERROR_INVAL;
+				*pos += n;
+			}
 		}
-		if (check == JSMN_ERROR_INVAL)
+	}
+
+	static int jsmnreader_validate_number(const unsigned char * s, unsigned int len, unsigned int * pos)
+	{
+		//-?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+		if (s[*pos] == '-')
+			(*pos)++;
+		if (*pos >= len)
+			return JSMN_ERROR_PART;
+		if (s[*pos] == '0')
+			(*pos)++;
+		else if (s[*pos] >= '1' && s[*pos] <= '9')
 		{
-			//printf("Error! Invalid format!\n");
-			reader->tokens_count = 0;
-			reader->tokens = (jsmntok_t *)realloc(reader->tokens, (reader->tokens_count)*sizeof(jsmntok_t));
+			while (*pos < len && s[*pos] >= '0' && s[*pos] <= '9')
+				(*pos)++;
+		}
+		else
 			return JSMN_ERROR_INVAL;
+		if (*pos < len && s[*pos] == '.')
+		{
+			(*pos)++;
+			if (*pos >= len)
+				return JSMN_ERROR_PART;
+			if (s[*pos] < '0' || s[*pos] > '9')
+				return JSMN_ERROR_INVAL;
+			while (*pos < len && s[*pos] >= '0' && s[*pos] <= '9')
+				(*pos)++;
 		}
-		if (check == JSMN_ERROR_PART)
+		if (*pos < len && (s[*pos] == 'e' || s[*pos] == 'E'))
 		{
-			//printf("Error! Incomplete JSON!\n");
-			reader->tokens_count = 0;
-			reader->tokens = (jsmntok_t *)realloc(reader->tokens, (reader->tokens_count)*sizeof(jsmntok_t));
-			return JSMN_ERROR_PART;
+			(*pos)++;
+			if (*pos < len && (s[*pos] == '+' || s[*pos] == '-'))
+				(*pos)++;
+			if (*pos >= len)
+				return JSMN_ERROR_PART;
+			if (s[*pos] < '0' || s[*pos] > '9')
+				return JSMN_ERROR_INVAL;
+			while (*pos < len && s[*pos] >= '0' && s[*pos] <= '9')
+				(*pos)++;
 		}
-		//if (DEBUGPRINT_FILELOAD)
-		//	printf("Success!");
 		return JSMN_SUCCESS;
 	}
 
-	JSMN_API int jsmnreader_fileload(char * filepath, struct jsmnreader_obj_struct * reader)
+	static int jsmnreader_validate_literal(const unsigned char * s, unsigned int len, unsigned int * pos, const char * word)
 	{
-		FILE * str_file;
-		reader->txt_size = 0;
-		reader->tokens_count = 0;
-		//printf("FILE: %s\n", filepath);
-		str_file = fopen(filepath, "rb");
-		if (!str_file)
+		while (*word != '\0')
 		{
-			//if (DEBUGPRINT_FILELOAD)
-			//printf("Can't read %s.\n", filepath);
-			reader->txt = (char *)malloc(0);
-			reader->tokens = (jsmntok_t *)malloc(0);
-			reader->tokens_count = 0;
-			return JSMN_ERROR_NOFILE;
+			if (*pos >= len)
+				return JSMN_ERROR_PART;
+			if (s[*pos] != (unsigned char)*word)
+				return JSMN_ERROR_INVAL;
+			(*pos)++;
+			word++;
 		}
-		fseek(str_file, 0, SEEK_END); reader->txt_size = ftell(str_file); fseek(str_file, 0, SEEK_SET);
-		reader->txt = (char *)realloc(reader->txt, sizeof(char) * (reader->txt_size + 1)); fread(reader->txt, 1, reader->txt_size, str_file);
-		*(reader->txt + (reader->txt_size)) = '\0';
-		//if (DEBUGPRINT_FILELOAD)
-		//	printf("%s\n", reader->txt);
-		fclose(str_file);
+		return JSMN_SUCCESS;
+	}
+
+	static int jsmnreader_validate_key(const unsigned char * s, unsigned int len, unsigned int * pos)
+	{
+		int check;
+		*pos = jsmnreader_validate_space(s, len, *pos);
+		if (*pos >= len)
+			return JSMN_ERROR_PART;
+		if (s[*pos] != '"')
+			return JSMN_ERROR_INVAL;
+		check = jsmnreader_validate_string(s, len, pos);
+		if (check != JSMN_SUCCESS)
+			return check;
+		*pos = jsmnreader_validate_space(s, len, *pos);
+		if (*pos >= len)
+			return JSMN_ERROR_PART;
+		if (s[*pos] != ':')
+			return JSMN_ERROR_INVAL;
+		(*pos)++;
+		return JSMN_SUCCESS;
+	}
 
-		return jsmnreader_load(reader->txt, reader->txt_size, reader);
+	JSMN_API int jsmnreader_validate(const char * str, unsigned int str_size, unsigned int * error_pos)
+	{
+		//One bit per open object (1) or array (0), so the only memory used is JSMNR_MAX_DEPTH bits of stack
+		unsigned char stack[(JSMNR_MAX_DEPTH + 7) / 8];
+		const unsigned char * s;
+		unsigned int pos;
+		unsigned int depth;
+		int expect_value;
+		int in_object;
+		int check;
+		s = (const unsigned char *)str;
+		pos = 0;
+		depth = 0;
+		expect_value = 1;
+		check = JSMN_SUCCESS;
+		while (check == JSMN_SUCCESS)
+		{
+			pos = jsmnreader_validate_space(s, str_size, pos);
+			if (expect_value)
+			{
+				if (pos >= str_size)
+				{
+					check = JSMN_ERROR_PART;
+					break;
+				}
+				switch (s[pos])
+				{
+				case '{':
+				case '[':
+					if (depth >= JSMNR_MAX_DEPTH)
+					{
+						check = JSMN_ERROR_DEPTH;
+						break;
+					}
+					in_object = (s[pos] == '{');
+					if (in_object)
+						stack[depth / 8] |= (unsigned char)(1 << (depth % 8));
+					else
+						stack[depth / 8] &= (unsigned char)~(1 << (depth % 8));
+					depth++;
+					pos = jsmnreader_validate_space(s, str_size, pos + 1);
+					if (pos < str_size && s[pos] == (in_object ? '}' : ']'))
+					{
+						depth--;
+						pos++;
+						expect_value = 0;
+					}
+					else if (in_object)
+						check = jsmnreader_validate_key(s, str_size, &pos);
+					break;
+				case '"':
+					check = jsmnreader_validate_string(s, str_size, &pos);
+					expect_value = 0;
+					break;
+				case 't':
+					check = jsmnreader_validate_literal(s, str_size, &pos, "true");
+					expect_value = 0;
+					break;
+				case 'f':
+					check = jsmnreader_validate_literal(s, str_size, &pos, "false");
+					expect_value = 0;
+					break;
+				case 'n':
+					check = jsmnreader_validate_literal(s, str_size, &pos, "null");
+					expect_value = 0;
+					break;
+				case '-':
+				case '0':
+				case '1':
+				case '2':
+				case '3':
+				case '4':
+				case '5':
+				case '6':
+				case '7':
+				case '8':
+				case '9':
+					check = jsmnreader_validate_number(s, str_size, &pos);
+					expect_value = 0;
+					break;
+				default:
+					check = JSMN_ERROR_INVAL;
+					break;
+				}
+				continue;
+			}
+			//After a value comes a comma, the end of its object/array, or the end of the JSON
+			if (depth == 0)
+			{
+				if (pos < str_size)
+					check = JSMN_ERROR_INVAL;
+				break;
+			}
+			if (pos >= str_size)
+			{
+				check = JSMN_ERROR_PART;
+				break;
+			}
+			in_object = (stack[(depth - 1) / 8] >> ((depth - 1) % 8)) & 1;
+			if (s[pos] == ',')
+			{
+				pos++;
+				expect_value = 1;
+				if (in_object)
+					check = jsmnreader_validate_key(s, str_size, &pos);
+			}
+			else if (s[pos] == (in_object ? '}' : ']'))
+			{
+				depth--;
+				pos++;
+			}
+			else
+				check = JSMN_ERROR_INVAL;
+		}
+		if (error_pos != NULL)
+			*error_pos = pos;
+		return check;
 	}
 
 	JSMN_API void jsmnreader_print_string(jsmnreader_obj * reader)
 	{
 		if (reader->txt_size > 0)
 		{
-			printf("%s\n", reader->txt);
+			printf("%.*s\n", (int)reader->txt_size, reader->txt);
 		}
 	}
 
@@ -774,132 +3128,242 @@ extern "C" {
 		}
 	}
 
-	static char ** jsmnreader_tree_parsepath(char * mypath, char ** input_list, int * path_count)
+#ifdef JSMNR_STATS
+	JSMN_API void jsmnreader_stats_get(jsmnreader_obj * reader, jsmnreader_stats * stats)
 	{
-		char ** path_list;
-		char * temp_str;
+		*stats = reader->stats;
+	}
 
-		int temp_strlen;
-		unsigned int i;
-		int special_char;
-		path_list = input_list;
+	JSMN_API void jsmnreader_stats_reset(jsmnreader_obj * reader)
+	{
+		memset(&reader->stats, 0, sizeof(reader->stats));
+	}
+#endif
 
+#ifdef JSMNR_TRACE
+	JSMN_API void jsmnreader_trace_set(jsmnreader_trace_cb begin, jsmnreader_trace_cb end, void * userdata, struct jsmnreader_obj_struct * reader)
+	{
+		reader->trace_begin = begin;
+		reader->trace_end = end;
+		reader->trace_userdata = userdata;
+	}
+#endif
 
-		temp_str = (char *)malloc(sizeof(char) * 0);
-		path_list = (char **)malloc(sizeof(char *) * 0);
+	static int jsmnreader_token_escaped(unsigned int index, struct jsmnreader_obj_struct * reader)
+	{
+		//Strings are flagged while tokenizing. Primitives that weren't classified aren't, and can still hold a backslash.
+		if ((reader->tokens + index)->type == JSMN_STRING)
+			return ((reader->tokens + index)->subtype & JSMN_STRING_ESCAPED) != 0;
+		if ((reader->tokens + index)->subtype == 0)
+			return memchr(reader->txt + (reader->tokens + index)->start, '\\', (reader->tokens + index)->end - (reader->tokens + index)->start) != NULL;
+		return 0;
+	}
 
-		temp_strlen = 0;
-		//if (DEBUGPRINT_PARSEPATH) printf("Path: [%s]\n", mypath);
-		i = 0;
-		*path_count = 1;
-		special_char = 0;
-		if (strlen(mypath) == 0)
-			*path_count = 0;
-		while (i <= strlen(mypath))
+	static unsigned int jsmnreader_unescape(char * dst, const char * src, unsigned int len)
+	{
+		//Decodes '\\' and '"' escapes, dropping any other. Never writes ahead of where it reads, so 'dst' can be 'src'.
+		unsigned int r;
+		unsigned int w;
+		r = 0;
+		w = 0;
+		while (r < len)
 		{
-			if (strlen(mypath) == 0)
-				break;
-			special_char = 0;
-			if (mypath[i] == '\\')
+			if (src[r] != '\\')
 			{
-				temp_strlen += 1;
-				temp_str = (char *)realloc(temp_str, sizeof(char) * (temp_strlen));
-				temp_str[temp_strlen - 1] = '\0';
-
-				special_char = 1;
-				/*if (DEBUGPRINT_PARSEPATH)
-				{
-					printf("[%s]\n", temp_str);
-					printf("%d\n", *path_count);
-				}*/
-				path_list = (char **)realloc(path_list, sizeof(char *) * *path_count + 1);
-				path_list[*path_count - 1] = malloc(sizeof(char) * (temp_strlen));
-				memcpy(path_list[*path_count - 1], temp_str, sizeof(char) * (temp_strlen));
-
-				temp_strlen = 0;
-				temp_str = (char *)realloc(temp_str, 0);
-				*path_count = *path_count + 1;
+				dst[w] = src[r];
+				w++;
 			}
-			if (mypath[i] == '\0')
+			else
 			{
-				temp_strlen += 1;
-				temp_str = (char *)realloc(temp_str, sizeof(char) * (temp_strlen));
-				temp_str[temp_strlen - 1] = '\0';
+				switch (src[r + 1])
+				{
+				case '\\':
+				case '"':
+					dst[w] = src[r + 1];
+					w++;
+					break;
+				}
+				r++;
+			}
 
-				special_char = 1;
-				//if (DEBUGPRINT_PARSEPATH) printf("[%s]\n", temp_str);
+			r++;
+		}
+		return w;
+	}
 
-				path_list = (char **)realloc(path_list, sizeof(char *) * *path_count + 1);
-				path_list[*path_count - 1] = malloc(sizeof(char) * (temp_strlen));
-				memcpy(path_list[*path_count - 1], temp_str, sizeof(char) * (temp_strlen));
-				break;
+#ifndef JSMNR_NO_HEAP
+	static char * jsmnreader_extract(unsigned int start, unsigned int end, int escaped, int quoted, struct jsmnreader_obj_struct * reader)
+	{
+		//Decoding never makes the text longer, so the C string is allocated once at its full size
+		char * txt;
+		char * out;
+		unsigned int w;
+		txt = (char *)jsmnreader_malloc((end - start + 1 + (quoted ? 2 : 0)) * sizeof(char), reader);
+		JSMNR_STAT_ADD(reader, extract_calls, 1);
+		JSMNR_STAT_ADD(reader, extract_bytes, end - start);
+		out = txt;
+		if (quoted)
+			*(out++) = '"';
+		if (!escaped)
+		{
+			memcpy(out, reader->txt + start, end - start);
+			w = end - start;
+		}
+		else
+			w = jsmnreader_unescape(out, reader->txt + start, end - start);
+		if (quoted)
+			out[w++] = '"';
+		out[w] = '\0';
+		return txt;
+	}
+#endif
+
+	/* Primitives that aren't plain numbers or literals are copied into a buffer this big before being read as one */
+#ifndef JSMNR_NUMBER_MAX
+#define JSMNR_NUMBER_MAX 64
+#endif
+
+	static unsigned int jsmnreader_copy(unsigned int start, unsigned int end, int escaped, char * buffer, unsigned int buffer_size, struct jsmnreader_obj_struct * reader)
+	{
+		//Decodes like jsmnreader_extract() into the caller's buffer, stopping short of its end, and returns the length the whole C string needs
+		unsigned int r;
+		unsigned int w;
+		unsigned int limit;
+		limit = (buffer_size > 0) ? buffer_size - 1 : 0;
+		JSMNR_STAT_ADD(reader, extract_calls, 1);
+		JSMNR_STAT_ADD(reader, extract_bytes, end - start);
+		if (!escaped)
+		{
+			w = end - start;
+			if (limit > 0)
+				memcpy(buffer, reader->txt + start, (w < limit) ? w : limit);
+		}
+		else
+		{
+			w = 0;
+			for (r = start; r < end; r++)
+			{
+				if (reader->txt[r] != '\\')
+				{
+					if (w < limit)
+						buffer[w] = reader->txt[r];
+					w++;
+				}
+				else
+				{
+					if (reader->txt[r + 1] == '\\' || reader->txt[r + 1] == '"')
+					{
+						if (w < limit)
+							buffer[w] = reader->txt[r + 1];
+						w++;
+					}
+					r++;
+				}
 			}
-			if (!special_char)
+		}
+		if (buffer_size > 0)
+			buffer[(w < limit) ? w : limit] = '\0';
+		return w;
+	}
+
+	static void jsmnreader_print_text(unsigned int index, struct jsmnreader_obj_struct * reader)
+	{
+		//Outputs the token decoded like jsmnreader_extract(), straight from the JSON string
+		unsigned int r;
+		unsigned int start;
+		unsigned int end;
+		start = (reader->tokens + index)->start;
+		end = (reader->tokens + index)->end;
+		if (!jsmnreader_token_escaped(index, reader))
+		{
+			printf("%.*s", (int)(end - start), reader->txt + start);
+			return;
+		}
+		for (r = start; r < end; r++)
+		{
+			if (reader->txt[r] != '\\')
+				putchar(reader->txt[r]);
+			else
 			{
-				temp_strlen += 1;
-				temp_str = (char *)realloc(temp_str, sizeof(char) * (temp_strlen));
-				temp_str[temp_strlen - 1] = mypath[i];
+				if (reader->txt[r + 1] == '\\' || reader->txt[r + 1] == '"')
+					putchar(reader->txt[r + 1]);
+				r++;
 			}
-			//if (DEBUGPRINT_PARSEPATH) printf("%c\n", mypath[i]);
-			i++;
 		}
-		//if (DEBUGPRINT_PARSEPATH) printf("COUNT %d\n", *path_count);
-		free(temp_str);
+	}
 
-		return path_list;
+	static unsigned int jsmnreader_tree_pathcount(char * mypath)
+	{
+		unsigned int count;
+		if (*mypath == '\0')
+			return 0;
+		count = 1;
+		while (*mypath != '\0')
+		{
+			if (*mypath == '\\')
+				count++;
+			mypath++;
+		}
+		return count;
 	}
 
-	static char * jsmnreader_extract(unsigned int start, unsigned int end, struct jsmnreader_obj_struct * reader)
+	static int jsmnreader_token_keycmp(unsigned int index, const char * key, unsigned int key_len, struct jsmnreader_obj_struct * reader)
 	{
-		char * txt;
+		//Compares the token's text against 'key' the same way jsmnreader_extract() decodes it, without allocating.
 		unsigned int r;
 		unsigned int w;
-		txt = (char *)malloc(0 * sizeof(char));
-		//printf("(%d,", reader->txt_size);
-		//printf("%d,%d)", start, end);
-		//printf("\n");
-		r = start;
+		unsigned int end;
+		r = (reader->tokens + index)->start;
+		end = (reader->tokens + index)->end;
+		if (end - r < key_len)
+			return 0; //Escapes only ever shorten the text, so it can't match
+		if (!jsmnreader_token_escaped(index, reader))
+			return (end - r == key_len && memcmp(reader->txt + r, key, key_len) == 0);
 		w = 0;
 		while (r < end)
 		{
-			//printf("%c (%d < %d)\n", reader->txt[r], r, end);
 			if (reader->txt[r] != '\\')
 			{
-				w += 1;
-				txt = (char *)realloc(txt, (w + 1)* sizeof(char));
-				txt[w - 1] = reader->txt[r];
-				txt[w] = '\0';
+				if (w >= key_len || key[w] != reader->txt[r])
+					return 0;
+				w++;
 			}
 			else
 			{
 				switch (reader->txt[r + 1])
 				{
 				case '\\':
-					w += 1;
-					txt = (char *)realloc(txt, (w + 1)* sizeof(char));
-					txt[w - 1] = '\\';
-					txt[w] = '\0';
-					break;
 				case '"':
-					w += 1;
-					txt = (char *)realloc(txt, (w + 1)* sizeof(char));
-					txt[w - 1] = '"';
-					txt[w] = '\0';
+					if (w >= key_len || key[w] != reader->txt[r + 1])
+						return 0;
+					w++;
 					break;
 				}
 				r++;
 			}
-
 			r++;
 		}
-		//printf("[%s]\n", txt);
-		return txt;
+		return (w == key_len);
+	}
+
+	static const char * jsmnreader_token_number(unsigned int index, char * num_str, jsmnreader_obj * reader)
+	{
+		//Numbers are always followed by a delimiter within the JSON string, so they can be read in place. Primitives the tokenizer couldn't classify are copied out first
+		if ((reader->tokens + index)->subtype & (JSMN_PRIMITIVE_INT | JSMN_PRIMITIVE_FLOAT))
+			return reader->txt + (reader->tokens + index)->start;
+		if ((reader->tokens + index)->subtype == 0)
+		{
+			jsmnreader_copy((reader->tokens + index)->start, (reader->tokens + index)->end, jsmnreader_token_escaped(index, reader), num_str, JSMNR_NUMBER_MAX, reader);
+			return num_str;
+		}
+		return NULL;
 	}
 
 	JSMN_API int jsmnreader_token_get_int(unsigned int index, jsmnreader_obj * reader)
 	{
 		int num;
-		char * raw_str;
+		char num_str[JSMNR_NUMBER_MAX];
+		const char * num_txt;
 		num = 0;
 		if (reader->tokens_count > 0)
 		{
@@ -907,14 +3371,10 @@ extern "C" {
 			{
 				if (((reader->tokens + index)->type == JSMN_PRIMITIVE))
 				{
-					raw_str = jsmnreader_extract((reader->tokens + index)->start, (reader->tokens + index)->end, reader);
-					num = strtol(raw_str,NULL,10);
-                    if (raw_str[0]=='t')
-					{
-                        if (strcmp(raw_str,"true")==0)
-                            num=1;
-					}
-					free(raw_str);
+					if ((reader->tokens + index)->subtype & JSMN_PRIMITIVE_TRUE)
+						num = 1;
+					else if ((num_txt = jsmnreader_token_number(index, num_str, reader)) != NULL)
+						num = strtol(num_txt, NULL, 10);
 				}
 			}
 		}
@@ -924,7 +3384,8 @@ extern "C" {
     JSMN_API unsigned int jsmnreader_token_get_uint(unsigned int index, jsmnreader_obj * reader)
 	{
 		unsigned int num;
-		char * raw_str;
+		char num_str[JSMNR_NUMBER_MAX];
+		const char * num_txt;
 		num = 0;
 		if (reader->tokens_count > 0)
 		{
@@ -932,45 +3393,257 @@ extern "C" {
 			{
 				if (((reader->tokens + index)->type == JSMN_PRIMITIVE))
 				{
-					raw_str = jsmnreader_extract((reader->tokens + index)->start, (reader->tokens + index)->end, reader);
-					num = strtoul(raw_str,NULL,10);
-                    if (raw_str[0]=='t')
-					{
-                        if (strcmp(raw_str,"true")==0)
-                            num=1;
-					}
-					free(raw_str);
+					if ((reader->tokens + index)->subtype & JSMN_PRIMITIVE_TRUE)
+						num = 1;
+					else if ((num_txt = jsmnreader_token_number(index, num_str, reader)) != NULL)
+						num = strtoul(num_txt, NULL, 10);
+				}
+			}
+		}
+		return num;
+	}
+
+	JSMN_API float jsmnreader_token_get_float(unsigned int index, jsmnreader_obj * reader)
+	{
+		float num;
+		char num_str[JSMNR_NUMBER_MAX];
+		const char * num_txt;
+		num = 0;
+		if (reader->tokens_count > 0)
+		{
+			if (index >= 0 && index < reader->tokens_count)
+			{
+				if (((reader->tokens + index)->type == JSMN_PRIMITIVE))
+				{
+					if ((reader->tokens + index)->subtype & JSMN_PRIMITIVE_TRUE)
+						num = 1;
+					else if ((num_txt = jsmnreader_token_number(index, num_str, reader)) != NULL)
+						num = strtof(num_txt, NULL);
 				}
 			}
 		}
-		return num;
+		return num;
+	}
+
+	static const char * jsmnreader_digits(const char * s, const char * end, unsigned long long * value)
+	{
+		//Appends the digits from 's' to 'value' and returns where they end. Past 19 digits 'value' wraps, so callers count them from where they end.
+		//With JSMNR_SWAR, eight bytes at a time within one register: the run of digits ends at the lowest byte flagged as not one, and its value comes from adding
+		//neighbouring digits, then pairs, then fours, with the bytes past the run shifted out as leading zeros.
+#ifdef JSMNR_SWAR
+		static const unsigned long long scale[9] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+		unsigned long long chunk;
+		unsigned long long flags;
+		unsigned int run;
+		while (end - s >= 8)
+		{
+			memcpy(&chunk, s, 8);
+			chunk ^= 0x3030303030303030ULL;
+			//A byte's top bit ends up set unless it was '0' to '9'. Carries only run into later bytes, past the first flagged one
+			flags = ((chunk + 0x7676767676767676ULL) | chunk) & 0x8080808080808080ULL;
+			run = (flags != 0) ? (unsigned int)__builtin_ctzll(flags) / 8 : 8;
+			if (run == 0)
+				return s;
+			chunk <<= 8 * (8 - run);
+			chunk = ((chunk & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+			chunk = ((chunk & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+			chunk = (((chunk & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32) & 0xFFFFFFFFULL;
+			*value = *value * scale[run] + chunk;
+			s += run;
+			if (run < 8)
+				return s;
+		}
+#endif
+		while (s < end && *s >= '0' && *s <= '9')
+		{
+			*value = *value * 10 + (unsigned long long)(*s - '0');
+			s++;
+		}
+		return s;
+	}
+
+	static int jsmnreader_number_double(unsigned int index, double * value, jsmnreader_obj * reader)
+	{
+		//Numbers the tokenizer classified are known to be well formed. Up to 19 significant digits with a small enough mantissa and exponent convert exactly with one
+		//multiply or divide by an exact power of ten (Clinger's fast path), the rest go to strtod().
+#if defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD == 0 || FLT_EVAL_METHOD == 16)
+		static const double powers[23] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+#endif
+		const char * s;
+		const char * end;
+		const char * digits;
+		const char * fraction;
+		unsigned long long mantissa;
+		unsigned int count;
+		int exponent;
+		int e;
+		int negative;
+		int e_negative;
+		*value = 0;
+		if ((reader->tokens + index)->type != JSMN_PRIMITIVE || !((reader->tokens + index)->subtype & (JSMN_PRIMITIVE_INT | JSMN_PRIMITIVE_FLOAT)))
+			return 0;
+		s = reader->txt + (reader->tokens + index)->start;
+		end = reader->txt + (reader->tokens + index)->end;
+		negative = (*s == '-');
+		if (negative)
+			s++;
+		while (s < end && *s == '0')
+			s++;
+		mantissa = 0;
+		exponent = 0;
+		digits = s;
+		s = jsmnreader_digits(s, end, &mantissa);
+		count = (unsigned int)(s - digits);
+		if (s < end && *s == '.')
+		{
+			s++;
+			fraction = s;
+			//Zeros right after the point only move the exponent, when nothing came before them
+			if (count == 0)
+			{
+				while (s < end && *s == '0')
+					s++;
+			}
+			digits = s;
+			s = jsmnreader_digits(s, end, &mantissa);
+			count += (unsigned int)(s - digits);
+			exponent -= (int)(s - fraction);
+		}
+		if (count > 19)
+			goto slow;
+		if (s < end)
+		{
+			s++;
+			e_negative = (*s == '-');
+			if (*s == '-' || *s == '+')
+				s++;
+			e = 0;
+			while (s < end)
+			{
+				if (e < 100000)
+					e = e * 10 + (*s - '0');
+				s++;
+			}
+			exponent += e_negative ? -e : e;
+		}
+		if (mantissa == 0)
+		{
+			*value = negative ? -0.0 : 0.0;
+			return 1;
+		}
+		//16 is 0 with _Float16 added (GCC with AVX512-FP16), floats and doubles are still evaluated in their own types
+#if defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD == 0 || FLT_EVAL_METHOD == 16)
+		if (mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+		{
+			*value = (exponent < 0) ? (double)mantissa / powers[-exponent] : (double)mantissa * powers[exponent];
+			if (negative)
+				*value = -*value;
+			return 1;
+		}
+#endif
+	slow:
+		//In place, as with jsmnreader_token_number()
+		*value = strtod(reader->txt + (reader->tokens + index)->start, NULL);
+		if (*value - *value != 0)
+		{
+			//Past a double's range
+			*value = 0;
+			return 0;
+		}
+		return 1;
+	}
+
+	static int jsmnreader_number_int64(unsigned int index, long long * value, jsmnreader_obj * reader)
+	{
+		//Integers are read straight from their digits, decimals through jsmnreader_number_double() and cut toward zero
+		const char * s;
+		const char * end;
+		unsigned long long magnitude;
+		double real;
+		int negative;
+		*value = 0;
+		if ((reader->tokens + index)->type != JSMN_PRIMITIVE)
+			return 0;
+		if ((reader->tokens + index)->subtype & JSMN_PRIMITIVE_INT)
+		{
+			s = reader->txt + (reader->tokens + index)->start;
+			end = reader->txt + (reader->tokens + index)->end;
+			negative = (*s == '-');
+			if (negative)
+				s++;
+			while (end - s > 1 && *s == '0')
+				s++;
+			magnitude = 0;
+			jsmnreader_digits(s, end, &magnitude);
+			if (end - s > 19 || magnitude > (negative ? 9223372036854775808ULL : 9223372036854775807ULL))
+				return 0;
+			*value = negative ? -(long long)(magnitude - 1) - 1 : (long long)magnitude;
+			return 1;
+		}
+		if ((reader->tokens + index)->subtype & JSMN_PRIMITIVE_FLOAT)
+		{
+			if (!jsmnreader_number_double(index, &real, reader) || real >= 9223372036854775808.0 || real < -9223372036854775808.0)
+				return 0;
+			*value = (long long)real;
+			return 1;
+		}
+		return 0;
 	}
 
-	JSMN_API float jsmnreader_token_get_float(unsigned int index, jsmnreader_obj * reader)
+	static int jsmnreader_number_float(unsigned int index, float * value, jsmnreader_obj * reader)
 	{
-		float num;
-		char * raw_str;
-		num = 0;
-		if (reader->tokens_count > 0)
+		//The closest double, rounded again to a float, is the closest float unless it landed exactly halfway between two floats, which shows in the 29 bits a float
+		//drops. Those, and numbers small enough for floats to lose precision, are read again with strtof(), so the result is always the same as strtof()'s
+		double real;
+#if FLT_MANT_DIG == 24 && DBL_MANT_DIG == 53
+		unsigned long long bits;
+#endif
+		*value = 0;
+		//Up to halfway past FLT_MAX to the next power of two still rounds down to FLT_MAX
+		if (!jsmnreader_number_double(index, &real, reader) || real >= 3.4028235677973366e+38 || real <= -3.4028235677973366e+38)
+			return 0;
+#if FLT_MANT_DIG == 24 && DBL_MANT_DIG == 53
+		memcpy(&bits, &real, sizeof(bits));
+		if ((bits & 0x1FFFFFFFULL) != 0x10000000ULL && (real == 0 || real >= FLT_MIN || real <= -FLT_MIN))
 		{
-			if (index >= 0 && index < reader->tokens_count)
-			{
-				if (((reader->tokens + index)->type == JSMN_PRIMITIVE))
-				{
-					raw_str = jsmnreader_extract((reader->tokens + index)->start, (reader->tokens + index)->end, reader);
-					num = (float) strtod(raw_str,NULL);
-					if (raw_str[0]=='t')
-					{
-                        if (strcmp(raw_str,"true")==0)
-                            num=1;
-					}
-					free(raw_str);
-				}
-			}
+			*value = (float)real;
+			return 1;
 		}
-		return num;
+#endif
+		*value = strtof(reader->txt + (reader->tokens + index)->start, NULL);
+		return 1;
+	}
+
+	static int jsmnreader_token_int64(unsigned int index, long long * value, jsmnreader_obj * reader)
+	{
+		//A primitive's value, with any exponent applied before decimals are cut toward zero, so "1e5" is 100000 where jsmnreader_token_get_int() stops at the 'e'.
+		//Returns 0 for numbers past a long long's range
+		char num_str[JSMNR_NUMBER_MAX];
+		*value = 0;
+		if ((reader->tokens + index)->subtype & JSMN_PRIMITIVE_TRUE)
+			*value = 1;
+		else if ((reader->tokens + index)->subtype & (JSMN_PRIMITIVE_INT | JSMN_PRIMITIVE_FLOAT))
+			return jsmnreader_number_int64(index, value, reader);
+		else if ((reader->tokens + index)->subtype == 0)
+			*value = strtoll(jsmnreader_token_number(index, num_str, reader), NULL, 10);
+		return 1;
 	}
 
+	static int jsmnreader_token_double(unsigned int index, double * value, jsmnreader_obj * reader)
+	{
+		//jsmnreader_token_get_float() for primitives, without rounding to a float. Returns 0 for numbers past a double's range
+		char num_str[JSMNR_NUMBER_MAX];
+		*value = 0;
+		if ((reader->tokens + index)->subtype & JSMN_PRIMITIVE_TRUE)
+			*value = 1;
+		else if ((reader->tokens + index)->subtype & (JSMN_PRIMITIVE_INT | JSMN_PRIMITIVE_FLOAT))
+			return jsmnreader_number_double(index, value, reader);
+		else if ((reader->tokens + index)->subtype == 0)
+			*value = strtod(jsmnreader_token_number(index, num_str, reader), NULL);
+		return 1;
+	}
+
+#ifndef JSMNR_NO_HEAP
 	JSMN_API char * jsmnreader_token_get_string(unsigned int index, jsmnreader_obj * reader)
 	{
 		char * raw_str;
@@ -980,7 +3653,7 @@ extern "C" {
 			{
 				if ( ((reader->tokens + index)->type == JSMN_STRING) || ((reader->tokens + index)->type == JSMN_PRIMITIVE) )
 				{
-					raw_str = jsmnreader_extract((reader->tokens + index)->start, (reader->tokens + index)->end, reader);
+					raw_str = jsmnreader_extract((reader->tokens + index)->start, (reader->tokens + index)->end, jsmnreader_token_escaped(index, reader), 0, reader);
 					return raw_str;
 				}
 			}
@@ -988,10 +3661,29 @@ extern "C" {
 		return "";
 	}
 
+#endif
+
+	JSMN_API int jsmnreader_token_copy_string(unsigned int index, char * buffer, unsigned int buffer_size, jsmnreader_obj * reader)
+	{
+		if (index < reader->tokens_count)
+		{
+			if ((reader->tokens + index)->type == JSMN_STRING || (reader->tokens + index)->type == JSMN_PRIMITIVE)
+				return jsmnreader_copy((reader->tokens + index)->start, (reader->tokens + index)->end, jsmnreader_token_escaped(index, reader), buffer, buffer_size, reader);
+		}
+		if (buffer_size > 0)
+			*buffer = '\0';
+		return -1;
+	}
+
+	JSMN_API int jsmnreader_token_subtype(unsigned int index, jsmnreader_obj * reader)
+	{
+		if (index < reader->tokens_count && (reader->tokens + index)->type == JSMN_PRIMITIVE)
+			return (reader->tokens + index)->subtype;
+		return 0;
+	}
     JSMN_API int jsmnreader_token_is_null(unsigned int index, jsmnreader_obj * reader)
 	{
 		int num;
-		char * raw_str;
 		num = 0;
 		if (reader->tokens_count > 0)
 		{
@@ -999,13 +3691,8 @@ extern "C" {
 			{
 				if (((reader->tokens + index)->type == JSMN_PRIMITIVE))
 				{
-					raw_str = jsmnreader_extract((reader->tokens + index)->start, (reader->tokens + index)->end, reader);
-                    if (raw_str[0]=='n')
-					{
-                        if (strcmp(raw_str,"null")==0)
-                            num=1;
-					}
-					free(raw_str);
+					if ((reader->tokens + index)->subtype & (JSMN_PRIMITIVE_NULL))
+						num = 1;
 				}
 			}
 		}
@@ -1015,7 +3702,6 @@ extern "C" {
     JSMN_API int jsmnreader_token_is_special(unsigned int index, jsmnreader_obj * reader)
 	{
 		int num;
-		char * raw_str;
 		num = 0;
 		if (reader->tokens_count > 0)
 		{
@@ -1023,31 +3709,15 @@ extern "C" {
 			{
 				if (((reader->tokens + index)->type == JSMN_PRIMITIVE))
 				{
-					raw_str = jsmnreader_extract((reader->tokens + index)->start, (reader->tokens + index)->end, reader);
-                    switch(raw_str[0])
-					{
-					    case 'n':
-                        if (strcmp(raw_str,"null")==0)
-                            num=1;
-                            break;
-
-                        case 't':
-                        if (strcmp(raw_str,"true")==0)
-                            num=1;
-                            break;
-
-                        case 'f':
-                        if (strcmp(raw_str,"false")==0)
-                            num=1;
-                            break;
-					}
-					free(raw_str);
+					if ((reader->tokens + index)->subtype & (JSMN_PRIMITIVE_NULL | JSMN_PRIMITIVE_TRUE | JSMN_PRIMITIVE_FALSE))
+						num = 1;
 				}
 			}
 		}
 		return num;
 	}
 
+#ifndef JSMNR_NO_HEAP
     JSMN_API char * jsmnreader_token_get_raw(unsigned int index, jsmnreader_obj * reader)
 	{
 		char * raw_str;
@@ -1058,12 +3728,12 @@ extern "C" {
 			    switch((reader->tokens + index)->type)
                 {
                     case JSMN_STRING:
-					raw_str = jsmnreader_extract(((reader->tokens + index)->start)-1, ((reader->tokens + index)->end)+1, reader);
+					raw_str = jsmnreader_extract((reader->tokens + index)->start, (reader->tokens + index)->end, jsmnreader_token_escaped(index, reader), 1, reader);
 					return raw_str;
                     break;
 
                     case JSMN_PRIMITIVE:
-					raw_str = jsmnreader_extract((reader->tokens + index)->start, (reader->tokens + index)->end, reader);
+					raw_str = jsmnreader_extract((reader->tokens + index)->start, (reader->tokens + index)->end, jsmnreader_token_escaped(index, reader), 0, reader);
 					return raw_str;
                     break;
 
@@ -1076,6 +3746,39 @@ extern "C" {
 		return "";
 	}
 
+#endif
+
+	JSMN_API void jsmnreader_insitu(jsmnreader_obj * reader)
+	{
+		//Each string's closing quote (or the delimiter after a primitive) becomes its '\0', decoding only ever shortens the text
+		unsigned int i;
+		jsmntok_t * token;
+		if (reader->insitu)
+			return;
+		for (i = 0; i < reader->tokens_count; i++)
+		{
+			token = reader->tokens + i;
+			if ((token->type == JSMN_STRING || token->type == JSMN_PRIMITIVE) && jsmnreader_token_escaped(i, reader))
+			{
+				token->end = token->start + jsmnreader_unescape(reader->txt + token->start, reader->txt + token->start, token->end - token->start);
+				token->subtype &= ~JSMN_STRING_ESCAPED;
+			}
+			if (token->type == JSMN_STRING || token->type == JSMN_PRIMITIVE)
+				*(reader->txt + token->end) = '\0';
+		}
+		reader->insitu = 1;
+	}
+
+	JSMN_API const char * jsmnreader_token_get_insitu(unsigned int index, jsmnreader_obj * reader)
+	{
+		if (reader->insitu && index < reader->tokens_count)
+		{
+			if ((reader->tokens + index)->type == JSMN_STRING || (reader->tokens + index)->type == JSMN_PRIMITIVE)
+				return reader->txt + (reader->tokens + index)->start;
+		}
+		return NULL;
+	}
+
 	JSMN_API unsigned int jsmnreader_token_get_object(unsigned int index, jsmnreader_obj * reader)
 	{
 		unsigned int num;
@@ -1127,342 +3830,617 @@ extern "C" {
 		return num;
 	}
 
-	static void jsmnreader_dataskip(unsigned int * r, unsigned int * objs, int mode, struct jsmnreader_obj_struct * reader)
+	static void jsmnreader_dataskip(unsigned int * r, struct jsmnreader_obj_struct * reader)
 	{
-		unsigned int temp_size;
-		unsigned int objs_sub;
-		int check_offset;
-		check_offset = 0;
-		temp_size = (reader->tokens + *r)->size;
-		objs_sub = temp_size;
-		//if (DEBUGPRINT_SKIP) printf("SIZE %d\n", temp_size);
+		//Moves 'r' from an object or array to the token after everything inside it. Tokens are in the order they start, so that's the first one starting past the container's end,
+		//found by galloping ahead and then a binary search rather than walking (or recursing into) the contents.
+		unsigned int low;
+		unsigned int high;
+		unsigned int probe;
+		unsigned int step;
+		int end;
+		end = (reader->tokens + *r)->end;
+		low = *r + 1;
+		probe = low;
+		step = 1;
+		while (probe < reader->tokens_count && (reader->tokens + probe)->start < end)
+		{
+			low = probe + 1;
+			probe += step;
+			step *= 2;
+		}
+		high = (probe < reader->tokens_count) ? probe : reader->tokens_count;
+		while (low < high)
+		{
+			probe = low + (high - low) / 2;
+			if ((reader->tokens + probe)->start < end)
+				low = probe + 1;
+			else
+				high = probe;
+		}
+		JSMNR_STAT_ADD(reader, skipped_tokens, low - *r);
+		*r = low;
+	}
 
-		if (mode == 0)
+	static unsigned int jsmnreader_token_next(unsigned int r, struct jsmnreader_obj_struct * reader)
+	{
+		//Returns the token after the value at 'r', skipping over its contents if it's an object or array.
+		switch ((reader->tokens + r)->type)
 		{
-			check_offset = 1;
+		case JSMN_OBJECT:
+		case JSMN_ARRAY:
+			jsmnreader_dataskip(&r, reader);
+			break;
+		default:
+			r++;
+			break;
 		}
-		*r = *r + 1;
-		while (*r < reader->tokens_count && objs_sub > 0)
+		return r;
+	}
+
+	JSMN_API int jsmnreader_iter_init(jsmnreader_iter * iter, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		iter->offset = offset;
+		iter->next = offset + 1;
+		iter->remaining = 0;
+		iter->key = -1;
+		if (reader->tokens_count > 0 && offset < reader->tokens_count)
 		{
-			//if (DEBUGPRINT_SKIP) printf("%d", *r);
-			switch ((reader->tokens + *r + check_offset)->type)
+			if ((reader->tokens + offset)->type == JSMN_OBJECT || (reader->tokens + offset)->type == JSMN_ARRAY)
 			{
-			default:
-				//if (DEBUGPRINT_SKIP) printf("\n");
-				if (mode == 1)
-					*r = *r + 1;
-				else
-					*r = *r + 2;
-				objs_sub -= 1;
-				//*objs -= 1;
-				break;
-			case JSMN_OBJECT:
-				//if (DEBUGPRINT_SKIP) printf(" ANOTHER OBJECT\n");
-				if (mode == 0)
-					*r = *r + 1;
-				jsmnreader_dataskip(r, &objs_sub, 0, reader);
-				objs_sub -= 1;
-				//*objs -= 1;
-				//*r = *r + 1;
-				break;
-			case JSMN_ARRAY:
-				//if (DEBUGPRINT_SKIP) printf(" ANOTHER ARRAY\n");
-				if (mode == 0)
-					*r = *r + 1;
-				jsmnreader_dataskip(r, &objs_sub, 1, reader);
-				objs_sub -= 1;
-				//*objs -= 1;
-				//*r = *r + 1;
-				break;
+				iter->remaining = (reader->tokens + offset)->size;
+				return 1;
 			}
 		}
+		return 0;
+	}
 
+	JSMN_API unsigned int jsmnreader_iter_next(jsmnreader_iter * iter, struct jsmnreader_obj_struct * reader)
+	{
+		unsigned int item;
+		if (iter->remaining == 0 || iter->next >= reader->tokens_count)
+			return -1;
+		item = iter->next;
+		iter->key = -1;
+		if ((reader->tokens + iter->offset)->type == JSMN_OBJECT)
+		{
+			iter->key = item;
+			item++;
+			if (item >= reader->tokens_count)
+				return -1;
+		}
+		iter->next = jsmnreader_token_next(item, reader);
+		iter->remaining--;
+		return item;
 	}
 
-	JSMN_API unsigned int jsmnreader_tree_get_x(char * mypath, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	static int jsmnreader_tree_index(char * seg, unsigned int seg_len, unsigned int * index)
 	{
-		unsigned int loc;
-		int in_offset;
-		int finished_loop;
-		int selected_token;
-		char * ex_txt;
-		char ** path_list;
-		unsigned int path_count;
 		unsigned int i;
+		if (seg_len == 0)
+			return 0;
+		*index = 0;
+		for (i = 0; i < seg_len; i++)
+		{
+			if (seg[i] < '0' || seg[i] > '9')
+				return 0;
+			//Too big for any array, rather than wrapped around to one of its elements
+			if (*index > (UINT_MAX - (unsigned int)(seg[i] - '0')) / 10)
+				return 0;
+			*index = (*index * 10) + (seg[i] - '0');
+		}
+		return 1;
+	}
+
+	static unsigned int jsmnreader_tree_child(char * seg, unsigned int seg_len, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		unsigned int index;
 		unsigned int objs;
 		unsigned int r;
-		r = 0;
-		loc = - 1;
-		path_list=malloc(0);
-		in_offset = 0;
-		if (reader->tokens_count > 0)
+		objs = (reader->tokens + offset)->size;
+		r = offset + 1;
+		switch ((reader->tokens + offset)->type)
 		{
-			if (offset >= 0 && offset < reader->tokens_count)
+		case JSMN_OBJECT:
+			while (objs > 0 && r + 1 < reader->tokens_count)
 			{
-				switch ((reader->tokens + offset)->type)
+				if (jsmnreader_token_keycmp(r, seg, seg_len, reader))
+					return r + 1;
+				r = jsmnreader_token_next(r + 1, reader);
+				objs--;
+			}
+			break;
+		case JSMN_ARRAY:
+			if (jsmnreader_tree_index(seg, seg_len, &index))
+				return jsmnreader_token_array(index, offset, reader);
+			break;
+		default:
+			break;
+		}
+		return -1;
+	}
+
+	static unsigned int jsmnreader_tree_walk(char * seg, unsigned int offset, jsmnreader_tree_cb callback, void * userdata, int * stop, struct jsmnreader_obj_struct * reader)
+	{
+		//Resolves the path one segment at a time, only branching out (recursing) on '*' segments.
+		jsmnreader_iter iter;
+		unsigned int found;
+		unsigned int seg_len;
+		unsigned int loc;
+		int last;
+		found = 0;
+		while (!*stop)
+		{
+			seg_len = strcspn(seg, "\\");
+			last = (seg[seg_len] == '\0');
+			if (seg_len == 1 && seg[0] == '*')
+			{
+				jsmnreader_iter_init(&iter, offset, reader);
+				while (!*stop && (loc = jsmnreader_iter_next(&iter, reader)) != (unsigned int)-1)
 				{
-				default:
-					//if (DEBUGPRINT_TREEGETX) printf("Error! The offset is not on an object or array!\n");
-					break;
-				case JSMN_OBJECT:
-					in_offset = 1;
-					break;
-				case JSMN_ARRAY:
-					in_offset = 1;
-					break;
+					if (last)
+					{
+						found++;
+						if (callback(loc, userdata))
+							*stop = 1;
+					}
+					else if ((reader->tokens + loc)->type == JSMN_OBJECT || (reader->tokens + loc)->type == JSMN_ARRAY)
+					{
+						found += jsmnreader_tree_walk(seg + seg_len + 1, loc, callback, userdata, stop, reader);
+					}
 				}
+				return found;
 			}
-			/*else
+			loc = jsmnreader_tree_child(seg, seg_len, offset, reader);
+			if (loc == (unsigned int)-1)
+				return found;
+			if (last)
 			{
-				if (DEBUGPRINT_TREEGETX) printf("Error! The offset is in out of range!\n");
-			}*/
+				found++;
+				if (callback(loc, userdata))
+					*stop = 1;
+				return found;
+			}
+			if ((reader->tokens + loc)->type != JSMN_OBJECT && (reader->tokens + loc)->type != JSMN_ARRAY)
+				return found;
+			offset = loc;
+			seg += seg_len + 1;
 		}
+		return found;
+	}
 
-		if (!in_offset)
+	static int jsmnreader_tree_first(unsigned int index, void * userdata)
+	{
+		*(unsigned int *)userdata = index;
+		return 1;
+	}
+
+	static int jsmnreader_tree_isoffset(unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		if (reader->tokens_count > 0 && offset < reader->tokens_count)
 		{
-			//if (DEBUGPRINT_TREEGETX) printf("Error! Invalid offset!\n");
-			return 0;
+			switch ((reader->tokens + offset)->type)
+			{
+			case JSMN_OBJECT:
+			case JSMN_ARRAY:
+				return 1;
+			default:
+				break;
+			}
 		}
+		return 0;
+	}
 
-		path_count = 0;
-		path_list = jsmnreader_tree_parsepath(mypath, path_list, &path_count);
+	JSMN_API unsigned int jsmnreader_tree_get_x(char * mypath, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		unsigned int loc;
+		int stop;
+#ifdef JSMNR_PATH_CACHE
+		unsigned int path_len;
+		unsigned long long hash;
+		jsmnreader_path_entry * entry;
+#endif
+#ifdef JSMNR_SPANS
+		jsmnreader_trace span;
+		jsmnreader_span_begin(&span, JSMNR_TRACE_TREE, mypath, offset, reader);
+#endif
+		loc = -1;
+		stop = 0;
+		if (!jsmnreader_tree_isoffset(offset, reader))
+		{
+			loc = -1;
+		}
+#ifdef JSMNR_PATH_CACHE
+		else
+		{
+			//A load always gives the same answer for the same path and offset, so it's only walked once
+			path_len = (unsigned int)strlen(mypath);
+			hash = jsmnreader_hash(mypath, path_len);
+			if (reader->path_entries == NULL && !reader->frozen)
+			{
+				reader->path_entries = (jsmnreader_path_entry *)jsmnreader_malloc(JSMNR_PATH_CACHE_SIZE * sizeof(jsmnreader_path_entry), reader);
+				if (reader->path_entries != NULL)
+					memset(reader->path_entries, 0, JSMNR_PATH_CACHE_SIZE * sizeof(jsmnreader_path_entry));
+			}
+			entry = NULL;
+			if (reader->path_entries != NULL)
+			{
+				if (reader->path_count >= JSMNR_PATH_CACHE_SIZE / 4 * 3 && !reader->frozen)
+					jsmnreader_path_invalidate(reader);
+				entry = jsmnreader_path_find(mypath, path_len, hash, offset, reader);
+			}
+			if (entry != NULL && entry->generation == reader->path_generation)
+			{
+				loc = entry->token;
+				JSMNR_STAT_ADD(reader, path_cache_hits, 1);
+			}
+			else
+			{
+				if (jsmnreader_tree_pathcount(mypath) > 0)
+					jsmnreader_tree_walk(mypath, offset, jsmnreader_tree_first, &loc, &stop, reader);
+				//Frozen readers still use what was cached before, but add nothing
+				if (entry != NULL && !reader->frozen)
+					jsmnreader_path_insert(entry, mypath, path_len, hash, offset, loc, reader);
+				JSMNR_STAT_ADD(reader, path_cache_misses, 1);
+			}
+		}
+#else
+		else if (jsmnreader_tree_pathcount(mypath) > 0)
+			jsmnreader_tree_walk(mypath, offset, jsmnreader_tree_first, &loc, &stop, reader);
+#endif
+#ifdef JSMNR_SPANS
+		jsmnreader_span_end(&span, (int)loc, reader);
+#endif
+		return loc;
+	}
 
+	JSMN_API unsigned int jsmnreader_tree_foreach(char * mypath, unsigned int offset, jsmnreader_tree_cb callback, void * userdata, struct jsmnreader_obj_struct * reader)
+	{
+		int stop;
+		unsigned int count;
+#ifdef JSMNR_SPANS
+		jsmnreader_trace span;
+		jsmnreader_span_begin(&span, JSMNR_TRACE_TREE, mypath, offset, reader);
+#endif
+		count = 0;
+		stop = 0;
+		if (jsmnreader_tree_isoffset(offset, reader) && jsmnreader_tree_pathcount(mypath) > 0)
+			count = jsmnreader_tree_walk(mypath, offset, callback, userdata, &stop, reader);
+#ifdef JSMNR_SPANS
+		jsmnreader_span_end(&span, (int)count, reader);
+#endif
+		return count;
+	}
 
-		/*if (DEBUGPRINT_TREEGETX)
-		{
-			printf("---\n");
-			for (i = 0; i < path_count; i++)
-				printf("%d: %s\n", i, path_list[i]);
-		}*/
-		objs = (reader->tokens + offset)->size;
-		r = offset + 1;
+	JSMN_API unsigned int jsmnreader_token_array_fill(unsigned int * buffer, unsigned int buffer_size, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		jsmnreader_iter iter;
+		unsigned int item;
+		unsigned int i;
 		i = 0;
-		//if (DEBUGPRINT_TREEGETX) printf("\nOffset: %d\nSize: %d\n", offset, objs);
-
-		while (objs > 0 && r<reader->tokens_count)
+		if (jsmnreader_token_get_array(offset, reader) != (unsigned int)-1)
 		{
-			finished_loop = 0;
-			selected_token = 0;
-			ex_txt = jsmnreader_extract((reader->tokens + r)->start, (reader->tokens + r)->end, reader);
-			if (path_count > 0 && i<path_count)
+			jsmnreader_iter_init(&iter, offset, reader);
+			while ((item = jsmnreader_iter_next(&iter, reader)) != (unsigned int)-1)
 			{
-				if (strcmp(path_list[i], ex_txt) == 0) selected_token = 1;
+				if (i < buffer_size)
+					*(buffer + i) = item;
+				i++;
 			}
-			//if (selected_token && DEBUGPRINT_TREEGETX) printf(">");
-			switch ((reader->tokens + (r + 1))->type)
+		}
+		return i;
+	}
+
+#ifndef JSMNR_NO_HEAP
+	JSMN_API void jsmnreader_token_array_tokens(unsigned int ** arrays, unsigned int * arrays_size, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		unsigned int size;
+		size = 0;
+		if (jsmnreader_token_get_array(offset, reader) != (unsigned int)-1)
+			size = (reader->tokens + offset)->size;
+		//The element count is known up front, so this is the only allocation
+		*arrays = (unsigned int *)jsmnreader_malloc(size * sizeof(unsigned int), reader);
+		*arrays_size = 0;
+		if (*arrays != NULL)
+			*arrays_size = jsmnreader_token_array_fill(*arrays, size, offset, reader);
+	}
+
+#endif
+
+	static void jsmnreader_column_set(jsmnreader_column * column, unsigned int row, unsigned int index, char * arena, unsigned int arena_size, unsigned int * used, struct jsmnreader_obj_struct * reader)
+	{
+		//Writes the row from the value at 'index', or as missing for -1, values of the wrong type and numbers that don't fit
+		unsigned int needed;
+		int found;
+		found = 0;
+		if (index != (unsigned int)-1)
+		{
+			if ((reader->tokens + index)->type == JSMN_PRIMITIVE)
+				found = 1;
+			else if ((reader->tokens + index)->type == JSMN_STRING && column->type == JSMNR_COLUMN_STRING)
+				found = 1;
+		}
+		switch (column->type)
+		{
+		case JSMNR_COLUMN_INT64:
+			*((long long *)column->values + row) = 0;
+			if (found)
+				found = jsmnreader_token_int64(index, (long long *)column->values + row, reader);
+			break;
+		case JSMNR_COLUMN_DOUBLE:
+			*((double *)column->values + row) = 0;
+			if (found)
+				found = jsmnreader_token_double(index, (double *)column->values + row, reader);
+			break;
+		case JSMNR_COLUMN_STRING:
+			*((unsigned int *)column->values + row) = -1;
+			if (found)
 			{
-			default:
-				finished_loop = 1;
-				/*if (DEBUGPRINT_TREEGETX)
-				{
-					printf("R[%d]: %s <???>\n", r, ex_txt);
-					printf("Clearly off now.\n");
-				}*/
-				break;
-			case JSMN_PRIMITIVE:
-				//if (DEBUGPRINT_TREEGETX) printf("R [%d]: %s <PRIMITIVE>\n", r, ex_txt);
-				if (selected_token)
-				{
-					free(ex_txt);
-					ex_txt = jsmnreader_extract((reader->tokens + r + 1)->start, (reader->tokens + r + 1)->end, reader);
-					//if (DEBUGPRINT_TREEGETX) printf("Found it! [%d] [%s]\n", r + 1, ex_txt);
-					loc = r + 1;
-					finished_loop = 1;
-				}
-				r += 2;
-				objs--;
-				break;
-			case JSMN_STRING:
-				//if (DEBUGPRINT_TREEGETX) printf("R [%d]: %s\n", r, ex_txt);
-				if (selected_token)
-				{
-					free(ex_txt);
-					ex_txt = jsmnreader_extract((reader->tokens + r + 1)->start, (reader->tokens + r + 1)->end, reader);
-					//if (DEBUGPRINT_TREEGETX) printf("Found it! [%d] [%s]\n", r + 1, ex_txt);
-					loc = r + 1;
-					finished_loop = 1;
-				}
-				r += 2;
-				objs--;
-				break;
-			case JSMN_OBJECT:
-				//if (DEBUGPRINT_TREEGETX) printf("R [%d]: %s <OBJECT>\n", r, ex_txt);
-				if (!selected_token)
-				{
-					r++;
-					jsmnreader_dataskip(&r, &objs, 0, reader);
-					objs--;
-				}
-				else
-				{
-					if (i == path_count - 1)
-					{
-						//if (DEBUGPRINT_TREEGETX) printf("Found it! [%d]\n", r + 1);
-						loc = r + 1;
-						finished_loop = 1;
-					}
-					else
-					{
-						//if (DEBUGPRINT_TREEGETX) printf("\n");
-						i += 1;
-						if (i > path_count - 1)
-							i = path_count - 1;
-						offset = r + 1;
-						objs = (reader->tokens + offset)->size;
-						r += 2;
-					}
-				}
-				break;
-			case JSMN_ARRAY:
-				//if (DEBUGPRINT_TREEGETX) printf("R [%d]: %s <ARRAY>\n", r, ex_txt);
-				if (!selected_token)
-				{
-					r++;
-					jsmnreader_dataskip(&r, &objs, 1, reader);
-					objs--;
-				}
+				//Past the end of the arena, the strings are still measured for 'arena_used'
+				if (*used < arena_size)
+					needed = jsmnreader_copy((reader->tokens + index)->start, (reader->tokens + index)->end, jsmnreader_token_escaped(index, reader), arena + *used, arena_size - *used, reader) + 1;
 				else
+					needed = jsmnreader_copy((reader->tokens + index)->start, (reader->tokens + index)->end, jsmnreader_token_escaped(index, reader), arena, 0, reader) + 1;
+				if (*used + needed <= arena_size)
+					*((unsigned int *)column->values + row) = *used;
+				*used += needed;
+			}
+			break;
+		}
+		if (column->found != NULL)
+			*(column->found + row) = (unsigned char)found;
+	}
+
+	JSMN_API unsigned int jsmnreader_token_array_columns(jsmnreader_column * columns, unsigned int columns_count, unsigned int rows_capacity, char * arena, unsigned int arena_size, unsigned int * arena_used, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		jsmnreader_iter rows;
+		jsmnreader_iter fields;
+		unsigned int row;
+		unsigned int item;
+		unsigned int value;
+		unsigned int c;
+		unsigned int k;
+		unsigned int guess;
+		unsigned int used;
+		row = 0;
+		used = 0;
+		guess = 0;
+		if (jsmnreader_token_get_array(offset, reader) != (unsigned int)-1)
+		{
+			jsmnreader_iter_init(&rows, offset, reader);
+			while ((item = jsmnreader_iter_next(&rows, reader)) != (unsigned int)-1)
+			{
+				if (row < rows_capacity)
 				{
-					if (i == path_count - 1)
-					{
-						//if (DEBUGPRINT_TREEGETX) printf("Found it! [%d]\n", r + 1);
-						loc = r + 1;
-						finished_loop = 1;
-					}
-					else
+					for (c = 0; c < columns_count; c++)
+						jsmnreader_column_set(columns + c, row, -1, arena, arena_size, &used, reader);
+					if ((reader->tokens + item)->type == JSMN_OBJECT)
 					{
-						finished_loop = 1;
+						jsmnreader_iter_init(&fields, item, reader);
+						while ((value = jsmnreader_iter_next(&fields, reader)) != (unsigned int)-1)
+						{
+							//Records tend to keep their keys in the same order, so the column after the last one matched is tried first
+							for (k = 0; k < columns_count; k++)
+							{
+								c = (guess + k < columns_count) ? guess + k : guess + k - columns_count;
+								if (jsmnreader_token_keycmp(fields.key, (columns + c)->key, (unsigned int)strlen((columns + c)->key), reader))
+									break;
+							}
+							if (k < columns_count)
+							{
+								//A key given twice is written twice, so the last one wins
+								jsmnreader_column_set(columns + c, row, value, arena, arena_size, &used, reader);
+								guess = (c + 1 < columns_count) ? c + 1 : 0;
+							}
+						}
 					}
 				}
-				break;
+				row++;
 			}
-			if (finished_loop)
-			{
+		}
+		if (arena_used != NULL)
+			*arena_used = used;
+		return row;
+	}
+
+	/* What jsmnreader_token_array_numbers() decodes into */
+	typedef enum {
+		JSMNR_NUMBER_INT32,
+		JSMNR_NUMBER_INT64,
+		JSMNR_NUMBER_FLOAT,
+		JSMNR_NUMBER_DOUBLE,
+	} jsmnreadernumber_t;
 
-				free(ex_txt);
+	static unsigned int jsmnreader_token_array_numbers(void * buffer, unsigned int buffer_size, jsmnreadernumber_t kind, unsigned int * error_index, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		jsmnreader_iter iter;
+		unsigned int item;
+		unsigned int i;
+		long long whole;
+		double real;
+		int ok;
+		if (error_index != NULL)
+			*error_index = -1;
+		if (jsmnreader_token_get_array(offset, reader) == (unsigned int)-1)
+			return 0;
+		jsmnreader_iter_init(&iter, offset, reader);
+		for (i = 0; i < buffer_size && (item = jsmnreader_iter_next(&iter, reader)) != (unsigned int)-1; i++)
+		{
+			switch (kind)
+			{
+			case JSMNR_NUMBER_INT32:
+				ok = jsmnreader_number_int64(item, &whole, reader) && whole >= INT_MIN && whole <= INT_MAX;
+				*((int *)buffer + i) = ok ? (int)whole : 0;
+				break;
+			case JSMNR_NUMBER_INT64:
+				ok = jsmnreader_number_int64(item, &whole, reader);
+				*((long long *)buffer + i) = whole;
+				break;
+			case JSMNR_NUMBER_FLOAT:
+				ok = jsmnreader_number_float(item, (float *)buffer + i, reader);
+				break;
+			default:
+				ok = jsmnreader_number_double(item, &real, reader);
+				*((double *)buffer + i) = real;
 				break;
 			}
-
-			free(ex_txt);
+			if (!ok && error_index != NULL && *error_index == (unsigned int)-1)
+				*error_index = i;
 		}
-		//if (DEBUGPRINT_TREEGETX) printf("---\n");
-		for (i = 0; i < path_count; i++)
-			free(path_list[i]);
-		free(path_list);
-		/*if (DEBUGPRINT_READERDATA)
-		{
+		return (reader->tokens + offset)->size;
+	}
+
+	JSMN_API unsigned int jsmnreader_token_array_get_int32(int * buffer, unsigned int buffer_size, unsigned int * error_index, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		return jsmnreader_token_array_numbers(buffer, buffer_size, JSMNR_NUMBER_INT32, error_index, offset, reader);
+	}
+
+	JSMN_API unsigned int jsmnreader_token_array_get_int64(long long * buffer, unsigned int buffer_size, unsigned int * error_index, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		return jsmnreader_token_array_numbers(buffer, buffer_size, JSMNR_NUMBER_INT64, error_index, offset, reader);
+	}
+
+	JSMN_API unsigned int jsmnreader_token_array_get_float(float * buffer, unsigned int buffer_size, unsigned int * error_index, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		return jsmnreader_token_array_numbers(buffer, buffer_size, JSMNR_NUMBER_FLOAT, error_index, offset, reader);
+	}
 
-			printf("Tokens: %d\n", reader->tokens_count);
-			for (i = 0; i < reader->tokens_count; i++)
+	JSMN_API unsigned int jsmnreader_token_array_get_double(double * buffer, unsigned int buffer_size, unsigned int * error_index, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		return jsmnreader_token_array_numbers(buffer, buffer_size, JSMNR_NUMBER_DOUBLE, error_index, offset, reader);
+	}
+
+#ifdef JSMNR_ARRAY_INDEX
+	static int jsmnreader_array_prepare(struct jsmnreader_obj_struct * reader)
+	{
+		//Every array's elements fit within the token count, so both buffers only grow with the token count
+		if (reader->array_capacity < reader->tokens_count)
+		{
+			free(reader->array_index);
+			free(reader->array_elements);
+			reader->array_index = (unsigned int *)jsmnreader_malloc(reader->tokens_count * sizeof(unsigned int), reader);
+			reader->array_elements = (unsigned int *)jsmnreader_malloc(reader->tokens_count * sizeof(unsigned int), reader);
+			reader->array_capacity = reader->tokens_count;
+			if (reader->array_index == NULL || reader->array_elements == NULL)
 			{
-				printf("%d: (%d,%d,%d,%d)", i, (reader->tokens + i)->type, (reader->tokens + i)->start, (reader->tokens + i)->end, (reader->tokens + i)->size);
-				if ((reader->tokens + i)->type == JSMN_STRING)
-				{
-					printf(" STR: ");
-					ex_txt = jsmnreader_extract((reader->tokens + i)->start, (reader->tokens + i)->end, reader);
-					printf("%s", ex_txt);
-					free(ex_txt);
-				}
-				printf("\n");
+				free(reader->array_index);
+				free(reader->array_elements);
+				reader->array_index = NULL;
+				reader->array_elements = NULL;
+				reader->array_capacity = 0;
+				return 0;
 			}
-		}*/
-
-		return loc;
+		}
+		memset(reader->array_index, 0, reader->tokens_count * sizeof(unsigned int));
+		reader->array_elements_count = 0;
+		reader->array_ready = 1;
+		return 1;
 	}
 
-	JSMN_API void jsmnreader_token_array_tokens(unsigned int ** arrays, unsigned int * arrays_size, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	static unsigned int jsmnreader_array_build(unsigned int * table, unsigned int offset, struct jsmnreader_obj_struct * reader)
 	{
-		int * edit;
-		int can_do;
-		//char * temp_str; //Delete later???
-		unsigned int size;
-		unsigned int i;
-		unsigned int objs;
 		unsigned int r;
-		size = 0;
-		can_do = 0;
-		r = 0;
-		/*if (DEBUGPRINT_ARRAYLIST)
+		unsigned int i;
+		r = offset + 1;
+		for (i = 0; i < (unsigned int)(reader->tokens + offset)->size && r < reader->tokens_count; i++)
 		{
-			jsmnreader_print_tokens(reader);
-			printf("Offset: %d\n", offset);
-		}*/
+			*(table + i) = r;
+			r = jsmnreader_token_next(r, reader);
+		}
+		return i;
+	}
 
-		*arrays = (int *)malloc(0);
-		*arrays_size = 0;
-		if (jsmnreader_token_get_array(offset, reader) != -1)
+	static unsigned int * jsmnreader_array_table(unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		//Builds the array's element table on first use
+		unsigned int start;
+#ifdef JSMNR_ATOMICS
+		unsigned int size;
+		unsigned int published;
+#endif
+		if (!reader->array_ready && (reader->frozen || !jsmnreader_array_prepare(reader)))
+			return NULL;
+		if (!reader->frozen)
 		{
-			size = (reader->tokens + offset)->size;
-			*arrays = (int *)realloc(*arrays,size*sizeof(int));
-			*arrays_size = size;
-			edit = *arrays;
-			i = 0;
-			objs = size;
-			r = offset + 1;
-			while (objs > 0 && r < reader->tokens_count)
+			if (*(reader->array_index + offset) == 0)
 			{
-				switch ((reader->tokens + r)->type)
-				{
-					default:
-						break;
-					case JSMN_STRING:
-						/*if (DEBUGPRINT_ARRAYLIST)
-						{
-							temp_str = jsmnreader_token_get_string(r, reader);
-							printf("%d STRING: %s\n", r, temp_str);
-							free(temp_str);
-						}*/
-						*(edit + i) = r; i++;
-						r++;
-						break;
-
-					case JSMN_PRIMITIVE:
-						/*if (DEBUGPRINT_ARRAYLIST)
-						{
-							temp_str = jsmnreader_token_get_string(r, reader);
-							printf("%d PRIMITIVE: %s\n", r, temp_str);
-							free(temp_str);
-						}*/
-						*(edit + i) = r; i++;
-						r++;
-						break;
-
-					case JSMN_OBJECT:
-						//if (DEBUGPRINT_ARRAYLIST) printf("%d OBJECT\n", r);
-						*(edit + i) = r; i++;
-						jsmnreader_dataskip(&r, &objs, 0, reader);
-						break;
+				start = reader->array_elements_count;
+				reader->array_elements_count += jsmnreader_array_build(reader->array_elements + start, offset, reader);
+				*(reader->array_index + offset) = start + 1;
+			}
+			return reader->array_elements + *(reader->array_index + offset) - 1;
+		}
+#ifdef JSMNR_ATOMICS
+		//Frozen, other threads may be building the same table: each builds into room of its own and publishes it with one compare and swap, so losing only wastes the room.
+		//The published start is all a thread looks at, and loading it with acquire makes the table behind it visible too
+		published = __atomic_load_n(reader->array_index + offset, __ATOMIC_ACQUIRE);
+		if (published != 0)
+			return reader->array_elements + published - 1;
+		size = (reader->tokens + offset)->size;
+		start = __atomic_fetch_add(&reader->array_elements_count, size, __ATOMIC_RELAXED);
+		if (start > reader->array_capacity || size > reader->array_capacity - start)
+			return NULL; //Out of room after lost races, the caller walks the array instead
+		jsmnreader_array_build(reader->array_elements + start, offset, reader);
+		published = 0;
+		if (__atomic_compare_exchange_n(reader->array_index + offset, &published, start + 1, 0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE))
+			published = start + 1;
+		return reader->array_elements + published - 1;
+#else
+		//Without atomics, jsmnreader_freeze() built every table beforehand
+		(void)start;
+		return reader->array_elements + *(reader->array_index + offset) - 1;
+#endif
+	}
 
-					case JSMN_ARRAY:
-						//if (DEBUGPRINT_ARRAYLIST) printf("%d ARRAY\n", r);
-						*(edit + i) = r; i++;
-						jsmnreader_dataskip(&r, &objs, 1, reader);
-						break;
-				}
-				objs--;
+#endif
+	JSMN_API void jsmnreader_freeze(jsmnreader_obj * reader)
+	{
+#if defined(JSMNR_ARRAY_INDEX) && !defined(JSMNR_ATOMICS)
+		unsigned int r;
+#endif
+		reader->frozen = 0;
+#ifdef JSMNR_ARRAY_INDEX
+		//Sized and cleared now, leaving only each array's table to be filled in by queries
+		if (reader->tokens_count > 0 && !reader->array_ready)
+			jsmnreader_array_prepare(reader);
+#ifndef JSMNR_ATOMICS
+		//Without atomics to publish tables with, every array's is built now, so frozen queries only read them
+		if (reader->array_ready)
+		{
+			for (r = 0; r < reader->tokens_count; r++)
+			{
+				if ((reader->tokens + r)->type == JSMN_ARRAY)
+					jsmnreader_array_table(r, reader);
 			}
 		}
+#endif
+#endif
+		reader->frozen = 1;
 	}
 
 	JSMN_API unsigned int jsmnreader_token_array(unsigned int index, unsigned int offset, struct jsmnreader_obj_struct * reader)
 	{
 		int can_do;
-		//char * temp_str; //Delete later???
 		unsigned int size;
 		unsigned int i;
 		unsigned int objs;
 		unsigned int r;
+#ifdef JSMNR_ARRAY_INDEX
+		unsigned int * table;
+#endif
 		size = 0;
 		can_do = 0;
 		r = 0;
-		/*if (DEBUGPRINT_ARRAYLIST)
-		{
-			jsmnreader_print_tokens(reader);
-			printf("Offset: %d\n", offset);
-		}*/
-		if (jsmnreader_token_get_array(offset, reader) != -1)
+		if (jsmnreader_token_get_array(offset, reader) != (unsigned int)-1)
 		{
 			size = (reader->tokens + offset)->size;
+#ifdef JSMNR_ARRAY_INDEX
+			if (index >= size)
+				return -1;
+			table = jsmnreader_array_table(offset, reader);
+			if (table != NULL)
+				return *(table + index);
+#endif
 			i = 0;
 			objs = size;
 			r = offset + 1;
@@ -1473,12 +4451,6 @@ extern "C" {
 				default:
 					break;
 				case JSMN_STRING:
-					/*if (DEBUGPRINT_ARRAYLIST)
-					{
-						temp_str = jsmnreader_token_get_string(r, reader);
-						printf("%d STRING: %s\n", r, temp_str);
-						free(temp_str);
-					}*/
 					if (i == index)
 						return r;
 					i++;
@@ -1486,12 +4458,6 @@ extern "C" {
 					break;
 
 				case JSMN_PRIMITIVE:
-					/*if (DEBUGPRINT_ARRAYLIST)
-					{
-						temp_str = jsmnreader_token_get_string(r, reader);
-						printf("%d PRIMITIVE: %s\n", r, temp_str);
-						free(temp_str);
-					}*/
 					if (i == index)
 						return r;
 					i++;
@@ -1499,19 +4465,17 @@ extern "C" {
 					break;
 
 				case JSMN_OBJECT:
-					//if (DEBUGPRINT_ARRAYLIST) printf("%d OBJECT\n", r);
 					if (i == index)
 						return r;
 					i++;
-					jsmnreader_dataskip(&r, &objs, 0, reader);
+					jsmnreader_dataskip(&r, reader);
 					break;
 
 				case JSMN_ARRAY:
-					//if (DEBUGPRINT_ARRAYLIST) printf("%d ARRAY\n", r);
 					if (i == index)
 						return r;
 					i++;
-					jsmnreader_dataskip(&r, &objs, 1, reader);
+					jsmnreader_dataskip(&r, reader);
 					break;
 				}
 				objs--;
@@ -1520,11 +4484,26 @@ extern "C" {
 		return -1;
 	}
 
+	JSMN_API unsigned int jsmnreader_token_array_next(unsigned int index, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		unsigned int r;
+		if (jsmnreader_token_get_array(offset, reader) != (unsigned int)-1)
+		{
+			if (index > offset && index < reader->tokens_count)
+			{
+				r = jsmnreader_token_next(index, reader);
+				//The next sibling still starts before the array's closing bracket
+				if (r < reader->tokens_count && (reader->tokens + r)->start < (reader->tokens + offset)->end)
+					return r;
+			}
+		}
+		return -1;
+	}
+
 	JSMN_API unsigned int jsmnreader_tree_anyprint(char * mypath, unsigned int offset, struct jsmnreader_obj_struct * reader)
 	{
 		int loc;
 		int type;
-		char * txt;
 		float num;
 		loc = jsmnreader_tree_get_x(mypath, offset, reader);
 		printf("%s -> ", mypath);
@@ -1543,9 +4522,9 @@ extern "C" {
 				break;
 
 			case JSMN_STRING:
-				txt = jsmnreader_token_get_string(loc, reader);
-				printf("(String) [%s] [%d]\n", txt, loc);
-				free(txt);
+				printf("(String) [");
+				jsmnreader_print_text(loc, reader);
+				printf("] [%d]\n", loc);
 				break;
 
 			case JSMN_PRIMITIVE:
@@ -1618,6 +4597,7 @@ extern "C" {
 		return num;
 	}
 
+#ifndef JSMNR_NO_HEAP
 	JSMN_API char * jsmnreader_tree_get_string(char * mypath, unsigned int offset, struct jsmnreader_obj_struct * reader)
 	{
 		int loc;
@@ -1635,7 +4615,7 @@ extern "C" {
 		}
 		else
 		{
-			txt = (char *) malloc(0);
+			txt = (char *)jsmnreader_malloc(0, reader);
 		}
 		return txt;
 	}
@@ -1657,17 +4637,33 @@ extern "C" {
 		}
 		else
 		{
-			txt = (char *) malloc(0);
+			txt = (char *)jsmnreader_malloc(0, reader);
 		}
 		return txt;
 	}
 
+#endif
+
+	JSMN_API int jsmnreader_tree_copy_string(char * mypath, unsigned int offset, char * buffer, unsigned int buffer_size, struct jsmnreader_obj_struct * reader)
+	{
+		return jsmnreader_token_copy_string(jsmnreader_tree_get_x(mypath, offset, reader), buffer, buffer_size, reader);
+	}
+
+	JSMN_API const char * jsmnreader_tree_get_insitu(char * mypath, unsigned int offset, struct jsmnreader_obj_struct * reader)
+	{
+		unsigned int loc;
+		loc = jsmnreader_tree_get_x(mypath, offset, reader);
+		if (loc != (unsigned int)-1)
+			return jsmnreader_token_get_insitu(loc, reader);
+		return NULL;
+	}
+
 	JSMN_API unsigned int jsmnreader_tree_get_object(char * mypath, unsigned int offset, struct jsmnreader_obj_struct * reader)
 	{
 		unsigned int loc;
 		int type;
 		loc = jsmnreader_tree_get_x(mypath, offset, reader);
-		if (loc != -1)
+		if (loc != (unsigned int)-1)
 		{
 			type = (reader->tokens + loc)->type;
 			if (type == JSMN_OBJECT)
@@ -1681,7 +4677,7 @@ extern "C" {
 		unsigned int loc;
 		int type;
 		loc = jsmnreader_tree_get_x(mypath, offset, reader);
-		if (loc != -1)
+		if (loc != (unsigned int)-1)
 		{
 			type = (reader->tokens + loc)->type;
 			if (type == JSMN_ARRAY)
@@ -1695,228 +4691,96 @@ extern "C" {
 		//jsmnreader_tree_get_x() is functionally the same. Implemented anyways for consistency.
 		unsigned int loc;
 		loc = jsmnreader_tree_get_x(mypath, offset, reader);
-		if (loc != -1)
+		if (loc != (unsigned int)-1)
 		{
 			return loc;
 		}
 		return -1;
 	}
 
-	JSMN_API void jsmnreader_token_object_tokens(unsigned int ** arrays, unsigned int * arrays_size, unsigned int offset, jsmnreaderobjread_t read_setting, struct jsmnreader_obj_struct * reader)
-    {
-        unsigned int * edit;
-        unsigned int z;
-		int in_offset;
-		int finished_loop;
-		int selected_token;
-		char * ex_txt;
-
-		char ** path_list;
-		int path_count;
-		int i;
-		unsigned int objs;
-		unsigned int r;
-		*arrays = (unsigned int *)malloc(0);
-		*arrays_size = 0;
-		edit = *arrays;
-		path_list=malloc(0);
-		r = 0;
-        z = 0;
-		in_offset = 0;
-		if (reader->tokens_count > 0)
+	JSMN_API unsigned int jsmnreader_token_object_fill(unsigned int * buffer, unsigned int buffer_size, unsigned int offset, jsmnreaderobjread_t read_setting, struct jsmnreader_obj_struct * reader)
+	{
+		jsmnreader_iter iter;
+		unsigned int item;
+		unsigned int i;
+		i = 0;
+		if (jsmnreader_token_get_object(offset, reader) != (unsigned int)-1)
 		{
-			if (offset >= 0 && offset < reader->tokens_count)
+			jsmnreader_iter_init(&iter, offset, reader);
+			while ((item = jsmnreader_iter_next(&iter, reader)) != (unsigned int)-1)
 			{
-				switch ((reader->tokens + offset)->type)
+				if (read_setting == JSMNR_BOTH || read_setting == JSMNR_KEYONLY)
 				{
-				case JSMN_OBJECT:
-					in_offset = 1;
-					break;
-				//case JSMN_ARRAY:
-				//	in_offset = 1;
-				//	break;
+					if (i < buffer_size)
+						*(buffer + i) = iter.key;
+					i++;
+				}
+				if (read_setting == JSMNR_BOTH || read_setting == JSMNR_ITEMONLY)
+				{
+					if (i < buffer_size)
+						*(buffer + i) = item;
+					i++;
 				}
 			}
 		}
+		return i;
+	}
 
-		if (!in_offset)
-        {
-            free(path_list);
-			return; //Invalid offset
-        }
-		path_count = 0;
-		path_list = jsmnreader_tree_parsepath("", path_list, &path_count);
-		objs = (reader->tokens + offset)->size;
-		r = offset + 1;
-		i = 0;
-		while (objs > 0 && r<reader->tokens_count)
+#ifndef JSMNR_NO_HEAP
+	JSMN_API void jsmnreader_token_object_tokens(unsigned int ** arrays, unsigned int * arrays_size, unsigned int offset, jsmnreaderobjread_t read_setting, struct jsmnreader_obj_struct * reader)
+	{
+		unsigned int size;
+		size = 0;
+		if (jsmnreader_token_get_object(offset, reader) != (unsigned int)-1)
 		{
-			finished_loop = 0;
-			selected_token = 0;
-			ex_txt = jsmnreader_extract((reader->tokens + r)->start, (reader->tokens + r)->end, reader);
-			if (path_count > 0 && i<path_count)
-			{
-				if (strcmp(path_list[i], ex_txt) == 0) selected_token = 1;
-			}
-			switch ((reader->tokens + (r + 1))->type)
-			{
-			default:
-				if (i == path_count)
-				{
-
-				    if (read_setting==JSMNR_BOTH || read_setting==JSMNR_KEYONLY)
-                    {
-                        *arrays = (int *)realloc(*arrays,(*arrays_size+1)*sizeof(int));*arrays_size+=1;edit = *arrays;*(edit + z) = r; z++;
-                    }
-				    if (read_setting==JSMNR_BOTH || read_setting==JSMNR_ITEMONLY)
-                    {
-                        *arrays = (int *)realloc(*arrays,(*arrays_size+1)*sizeof(int));*arrays_size+=1;edit = *arrays;*(edit + z) = r+1; z++;
-                    }
+			size = (reader->tokens + offset)->size;
+			if (read_setting == JSMNR_BOTH)
+				size *= 2;
+		}
+		//The item count is known up front, so this is the only allocation
+		*arrays = (unsigned int *)jsmnreader_malloc(size * sizeof(unsigned int), reader);
+		*arrays_size = 0;
+		if (*arrays != NULL)
+			*arrays_size = jsmnreader_token_object_fill(*arrays, size, offset, read_setting, reader);
+	}
 
-					//printf("R [%d]: %s <???>\n", r, ex_txt);
-				}
-				break;
-			case JSMN_PRIMITIVE:
-				if (i == path_count)
-				{
-				    if (read_setting==JSMNR_BOTH || read_setting==JSMNR_KEYONLY)
-                    {
-                        *arrays = (int *)realloc(*arrays,(*arrays_size+1)*sizeof(int));*arrays_size+=1;edit = *arrays;*(edit + z) = r; z++;
-                    }
-				    if (read_setting==JSMNR_BOTH || read_setting==JSMNR_ITEMONLY)
-                    {
-                        *arrays = (int *)realloc(*arrays,(*arrays_size+1)*sizeof(int));*arrays_size+=1;edit = *arrays;*(edit + z) = r+1; z++;
-                    }
-				    //*arrays[*arrays_size-1]=r;
-					//printf("R [%d]: %s <PRIMITIVE>\n", r, ex_txt);
-				}
-				r += 2;
-				objs--;
-				break;
-			case JSMN_STRING:
-				if (i == path_count)
-				{
-				    //printf("STR %d\n",*arrays_size);
-				    if (read_setting==JSMNR_BOTH || read_setting==JSMNR_KEYONLY)
-                    {
-                        *arrays = (int *)realloc(*arrays,(*arrays_size+1)*sizeof(int));*arrays_size+=1;edit = *arrays;*(edit + z) = r; z++;
-                    }
-				    if (read_setting==JSMNR_BOTH || read_setting==JSMNR_ITEMONLY)
-                    {
-                        *arrays = (int *)realloc(*arrays,(*arrays_size+1)*sizeof(int));*arrays_size+=1;edit = *arrays;*(edit + z) = r+1; z++;
-                    }
+#endif
 
-				}
-				r += 2;
-				objs--;
-				break;
-			case JSMN_OBJECT:
-				if (i == path_count)
-				{
-				    if (read_setting==JSMNR_BOTH || read_setting==JSMNR_KEYONLY)
-                    {
-                        *arrays = (int *)realloc(*arrays,(*arrays_size+1)*sizeof(int));*arrays_size+=1;edit = *arrays;*(edit + z) = r; z++;
-                    }
-				    if (read_setting==JSMNR_BOTH || read_setting==JSMNR_ITEMONLY)
-                    {
-                        *arrays = (int *)realloc(*arrays,(*arrays_size+1)*sizeof(int));*arrays_size+=1;edit = *arrays;*(edit + z) = r+1; z++;
-                    }
-
-					//printf("R [%d]: %s <OBJECT>\n", r, ex_txt);
-				}
-				if (!selected_token)
-				{
-					r++;
-					jsmnreader_dataskip(&r, &objs, 0, reader);
-					objs--;
-				}
-				else
-				{
-					if (i == path_count - 1)
-					{
-						i += 1;
-						offset = r + 1;
-						objs = (reader->tokens + offset)->size;
-						r += 2;
-					}
-					else
-					{
-						if (i == path_count-1)
-                        {
-							printf("\n");
-                        }
-						i += 1;
-						if (i > path_count - 1)
-							i = path_count - 1;
-						offset = r + 1;
-						objs = (reader->tokens + offset)->size;
-						r += 2;
-					}
-					//}
-				}
-				break;
-			case JSMN_ARRAY:
-				if (i == path_count)
+	JSMN_API unsigned int jsmnreader_token_object(unsigned int index, unsigned int offset, jsmnreaderobjread_t read_setting, struct jsmnreader_obj_struct * reader)
+	{
+		//Walks the object up to 'index' rather than listing all of its tokens, so nothing is allocated
+		jsmnreader_iter iter;
+		unsigned int item;
+		unsigned int i;
+		i = 0;
+		if (jsmnreader_token_get_object(offset, reader) != (unsigned int)-1)
+		{
+			jsmnreader_iter_init(&iter, offset, reader);
+			while ((item = jsmnreader_iter_next(&iter, reader)) != (unsigned int)-1)
+			{
+				if (read_setting == JSMNR_BOTH || read_setting == JSMNR_KEYONLY)
 				{
-				    if (read_setting==JSMNR_BOTH || read_setting==JSMNR_KEYONLY)
-                    {
-                        *arrays = (int *)realloc(*arrays,(*arrays_size+1)*sizeof(int));*arrays_size+=1;edit = *arrays;*(edit + z) = r; z++;
-                    }
-				    if (read_setting==JSMNR_BOTH || read_setting==JSMNR_ITEMONLY)
-                    {
-                        *arrays = (int *)realloc(*arrays,(*arrays_size+1)*sizeof(int));*arrays_size+=1;edit = *arrays;*(edit + z) = r+1; z++;
-                    }
-					//printf("R [%d]: %s <ARRAY>\n", r, ex_txt);
+					if (i == index)
+						return iter.key;
+					i++;
 				}
-				if (!selected_token)
+				if (read_setting == JSMNR_BOTH || read_setting == JSMNR_ITEMONLY)
 				{
-					r++;
-					jsmnreader_dataskip(&r, &objs, 1, reader);
-					objs--;
+					if (i == index)
+						return item;
+					i++;
 				}
-				break;
 			}
-
-			free(ex_txt);
-
 		}
-        free(path_list);
-		return;
+		return -1;
 	}
 
-    JSMN_API unsigned int jsmnreader_token_object(unsigned int index, unsigned int offset, jsmnreaderobjread_t read_setting, struct jsmnreader_obj_struct * reader)
-    {
-    unsigned int * arrays;
-    unsigned int arrays_size;
-    unsigned int num;
-    num=-1;
-    jsmnreader_token_object_tokens(&arrays, &arrays_size, offset, read_setting, reader);
-    if (arrays_size>0)
-    {
-        if (index>=0 && index<arrays_size)
-        {
-            num=arrays[index];
-            free(arrays);
-            return num;
-        }
-    }
-    free(arrays);
-    return num;
-    }
-
 	JSMN_API void jsmnreader_tree_print(char * mypath, unsigned int offset, struct jsmnreader_obj_struct * reader)
 	{
 		int in_offset;
-		int finished_loop;
-		int selected_token;
-		char * ex_txt;
-
-		char ** path_list;
-		int path_count;
-		int i;
+		unsigned int loc;
 		unsigned int objs;
 		unsigned int r;
-		path_list=malloc(0);
 		r = 0;
 
 		in_offset = 0;
@@ -1946,102 +4810,77 @@ extern "C" {
 		if (!in_offset)
 		{
 			printf("Error! Invalid offset!\n");
-            free(path_list);
 			return;
 		}
 
-		path_count = 0;
-		path_list = jsmnreader_tree_parsepath(mypath, path_list, &path_count);
-		objs = (reader->tokens + offset)->size;
-		r = offset + 1;
-		i = 0;
-		while (objs > 0 && r<reader->tokens_count)
+		loc = offset;
+		if (jsmnreader_tree_pathcount(mypath) > 0)
+			loc = jsmnreader_tree_get_x(mypath, offset, reader);
+		if (loc == (unsigned int)-1)
+			return;
+		objs = (reader->tokens + loc)->size;
+		r = loc + 1;
+		switch ((reader->tokens + loc)->type)
 		{
-			finished_loop = 0;
-			selected_token = 0;
-			ex_txt = jsmnreader_extract((reader->tokens + r)->start, (reader->tokens + r)->end, reader);
-			if (path_count > 0 && i<path_count)
-			{
-				if (strcmp(path_list[i], ex_txt) == 0) selected_token = 1;
-			}
-			switch ((reader->tokens + (r + 1))->type)
+		case JSMN_OBJECT:
+			while (objs > 0 && r + 1 < reader->tokens_count)
 			{
-			default:
-				if (i == path_count)
-				{
-					printf("R [%d]: %s <???>\n", r, ex_txt);
-				}
-				break;
-			case JSMN_PRIMITIVE:
-				if (i == path_count)
+				printf("R [%d]: ", r);
+				jsmnreader_print_text(r, reader);
+				switch ((reader->tokens + (r + 1))->type)
 				{
-					printf("R [%d]: %s <PRIMITIVE>\n", r, ex_txt);
+				default:
+					printf(" <?\?\?>\n");
+					break;
+				case JSMN_PRIMITIVE:
+					printf(" <PRIMITIVE>\n");
+					break;
+				case JSMN_STRING:
+					printf("\n");
+					break;
+				case JSMN_OBJECT:
+					printf(" <OBJECT>\n");
+					break;
+				case JSMN_ARRAY:
+					printf(" <ARRAY>\n");
+					break;
 				}
-				r += 2;
+				r = jsmnreader_token_next(r + 1, reader);
 				objs--;
-				break;
-			case JSMN_STRING:
-				if (i == path_count)
+			}
+			break;
+		case JSMN_ARRAY:
+			while (objs > 0 && r < reader->tokens_count)
+			{
+				switch ((reader->tokens + r)->type)
 				{
-					printf("R [%d]: %s\n", r, ex_txt);
+				default:
+					printf("R [%d]: <?\?\?>\n", r);
+					break;
+				case JSMN_PRIMITIVE:
+					printf("R [%d]: ", r);
+					jsmnreader_print_text(r, reader);
+					printf(" <PRIMITIVE>\n");
+					break;
+				case JSMN_STRING:
+					printf("R [%d]: ", r);
+					jsmnreader_print_text(r, reader);
+					printf("\n");
+					break;
+				case JSMN_OBJECT:
+					printf("R [%d]: <OBJECT>\n", r);
+					break;
+				case JSMN_ARRAY:
+					printf("R [%d]: <ARRAY>\n", r);
+					break;
 				}
-				r += 2;
+				r = jsmnreader_token_next(r, reader);
 				objs--;
-				break;
-			case JSMN_OBJECT:
-				if (i == path_count)
-				{
-					printf("R [%d]: %s <OBJECT>\n", r, ex_txt);
-				}
-				if (!selected_token)
-				{
-					r++;
-					jsmnreader_dataskip(&r, &objs, 0, reader);
-					objs--;
-				}
-				else
-				{
-					if (i == path_count - 1)
-					{
-						i += 1;
-						offset = r + 1;
-						objs = (reader->tokens + offset)->size;
-						r += 2;
-					}
-					else
-					{
-						if (i == path_count-1)
-                        {
-							printf("\n");
-                        }
-						i += 1;
-						if (i > path_count - 1)
-							i = path_count - 1;
-						offset = r + 1;
-						objs = (reader->tokens + offset)->size;
-						r += 2;
-					}
-					//}
-				}
-				break;
-			case JSMN_ARRAY:
-				if (i == path_count)
-				{
-					printf("R [%d]: %s <ARRAY>\n", r, ex_txt);
-				}
-				if (!selected_token)
-				{
-					r++;
-					jsmnreader_dataskip(&r, &objs, 1, reader);
-					objs--;
-				}
-				break;
 			}
-
-			free(ex_txt);
-
+			break;
+		default:
+			break;
 		}
-        free(path_list);
 		return;
 	}
 
@@ -0,0 +1,2092 @@
+/*
+* MIT License
+*
+* Copyright (c) 2023 Zachary Tabikh
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../jsmnreader.h"
+
+//Checks keep going after a failure, so one run reports all of them
+static unsigned int test_failures;
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #cond); test_failures++; } } while (0)
+
+#if defined(JSMNR_CACHE) || defined(JSMNR_BATCH)
+//These builds link pthreads (jsmnreader.h includes pthread.h for them), so they also run the tests that take threads
+#define TEST_THREADS
+#endif
+
+#ifdef JSMNR_NO_HEAP
+//Without the heap, readers take turns at two sets of buffers, as no test has more than two at once
+#define TEST_TOKENS 16384
+#define TEST_TXT 262144
+static jsmntok_t test_tokens[2][TEST_TOKENS];
+static char test_txt[2][TEST_TXT];
+static unsigned int test_turn;
+#endif
+
+static void test_init(jsmnreader_obj * reader)
+{
+#ifdef JSMNR_NO_HEAP
+	jsmnreader_init_buffers(test_tokens[test_turn], TEST_TOKENS, test_txt[test_turn], TEST_TXT, reader);
+	test_turn ^= 1;
+#else
+	jsmnreader_init(reader);
+#endif
+}
+
+static int test_load(const char * json, jsmnreader_obj * reader)
+{
+	return jsmnreader_load_mode((char *)json, (unsigned int)strlen(json), JSMNR_LOAD_COPY, reader);
+}
+
+//Collects the tokens jsmnreader_tree_foreach() calls back with
+typedef struct test_list_struct
+{
+	unsigned int ids[16];
+	unsigned int count;
+} test_list;
+
+static int test_collect(unsigned int index, void * userdata)
+{
+	test_list * list = (test_list *)userdata;
+	if (list->count < 16)
+	{
+		list->ids[list->count] = index;
+	}
+	list->count++;
+	return 0;
+}
+
+static void test_write_file(const char * path, const char * text)
+{
+	FILE * file;
+	file = fopen(path, "wb");
+	CHECK(file != NULL);
+	if (file != NULL)
+	{
+		fputs(text, file);
+		fclose(file);
+	}
+}
+
+/* ---- PATHS ---- */
+
+static void test_paths(void)
+{
+	jsmnreader_obj reader;
+	test_list list;
+	char buffer[8];
+	unsigned int i;
+
+	test_init(&reader);
+	CHECK(test_load("{\"items\":[{\"name\":\"a\",\"price\":1},{\"name\":\"b\",\"price\":2},{\"name\":\"c\"}],\"meta\":{\"x\":10,\"y\":20}}", &reader) == JSMN_SUCCESS);
+
+	//Element indexes
+	CHECK(jsmnreader_tree_get_int("items\\0\\price", 0, &reader) == 1);
+	CHECK(jsmnreader_tree_get_int("items\\1\\price", 0, &reader) == 2);
+	CHECK(jsmnreader_tree_copy_string("items\\2\\name", 0, buffer, sizeof(buffer), &reader) == 1 && strcmp(buffer, "c") == 0);
+	CHECK(jsmnreader_tree_get_x("items\\2\\price", 0, &reader) == (unsigned int)-1);
+	CHECK(jsmnreader_tree_get_x("items\\3", 0, &reader) == (unsigned int)-1);
+	CHECK(jsmnreader_tree_get_x("items\\x", 0, &reader) == (unsigned int)-1);
+	CHECK(jsmnreader_tree_get_x("items\\4294967297", 0, &reader) == (unsigned int)-1);
+	CHECK(jsmnreader_tree_get_x("items\\4294967296\\price", 0, &reader) == (unsigned int)-1);
+	CHECK(jsmnreader_tree_get_x("items\\00000000001\\price", 0, &reader) == jsmnreader_tree_get_x("items\\1\\price", 0, &reader));
+	CHECK(jsmnreader_tree_get_x("meta\\0", 0, &reader) == (unsigned int)-1);
+	CHECK(jsmnreader_tree_get_int("price", jsmnreader_tree_get_x("items\\1", 0, &reader), &reader) == 2);
+
+	//Wildcards, the first match for a lookup
+	CHECK(jsmnreader_tree_get_int("items\\*\\price", 0, &reader) == 1);
+	CHECK(jsmnreader_tree_get_int("meta\\*", 0, &reader) == 10);
+	CHECK(jsmnreader_tree_copy_string("*\\*\\name", 0, buffer, sizeof(buffer), &reader) == 1 && strcmp(buffer, "a") == 0);
+	CHECK(jsmnreader_tree_get_x("items\\*\\missing", 0, &reader) == (unsigned int)-1);
+
+	//Every match, in document order
+	memset(&list, 0, sizeof(list));
+	CHECK(jsmnreader_tree_foreach("items\\*\\price", 0, test_collect, &list, &reader) == 2);
+	CHECK(list.count == 2);
+	CHECK(jsmnreader_token_get_int(list.ids[0], &reader) == 1 && jsmnreader_token_get_int(list.ids[1], &reader) == 2);
+
+	memset(&list, 0, sizeof(list));
+	CHECK(jsmnreader_tree_foreach("*\\*\\name", 0, test_collect, &list, &reader) == 3);
+	CHECK(list.count == 3);
+	for (i = 0; i < 3 && i < list.count; i++)
+	{
+		CHECK(jsmnreader_token_copy_string(list.ids[i], buffer, sizeof(buffer), &reader) == 1 && buffer[0] == (char)('a' + i));
+		CHECK(i == 0 || list.ids[i - 1] < list.ids[i]);
+	}
+
+	memset(&list, 0, sizeof(list));
+	CHECK(jsmnreader_tree_foreach("meta\\*", 0, test_collect, &list, &reader) == 2);
+	CHECK(list.count == 2 && jsmnreader_token_get_int(list.ids[0], &reader) == 10 && jsmnreader_token_get_int(list.ids[1], &reader) == 20);
+
+	//Without a wildcard there's one match at most
+	memset(&list, 0, sizeof(list));
+	CHECK(jsmnreader_tree_foreach("items\\1\\name", 0, test_collect, &list, &reader) == 1);
+	CHECK(jsmnreader_tree_foreach("items\\9\\name", 0, test_collect, &list, &reader) == 0);
+	CHECK(list.count == 1);
+
+	jsmnreader_free(&reader);
+}
+
+/* ---- ARRAYS ---- */
+
+//Every way of reaching an array's elements has to give the same tokens
+static void test_array_agrees(unsigned int offset, jsmnreader_obj * reader)
+{
+	unsigned int filled[128];
+#ifndef JSMNR_NO_HEAP
+	unsigned int * tokens;
+	unsigned int tokens_size;
+#endif
+	unsigned int size;
+	unsigned int next;
+	unsigned int i;
+
+	size = jsmnreader_token_array_fill(filled, 128, offset, reader);
+	CHECK(size <= 128);
+	CHECK(size == jsmnreader_token_size(offset, reader));
+#ifndef JSMNR_NO_HEAP
+	jsmnreader_token_array_tokens(&tokens, &tokens_size, offset, reader);
+	CHECK(tokens_size == size);
+#endif
+	next = jsmnreader_token_array(0, offset, reader);
+	for (i = 0; i < size && i < 128; i++)
+	{
+		CHECK(jsmnreader_token_array(i, offset, reader) == filled[i]);
+#ifndef JSMNR_NO_HEAP
+		CHECK(i >= tokens_size || tokens[i] == filled[i]);
+#endif
+		CHECK(next == filled[i]);
+		next = jsmnreader_token_array_next(next, offset, reader);
+	}
+	CHECK(next == (unsigned int)-1);
+	CHECK(jsmnreader_token_array(size, offset, reader) == (unsigned int)-1);
+	//Backwards too, for the element table to be used out of order
+	for (i = size; i > 0 && i <= 128; i--)
+	{
+		CHECK(jsmnreader_token_array(i - 1, offset, reader) == filled[i - 1]);
+	}
+#ifndef JSMNR_NO_HEAP
+	free(tokens);
+#endif
+}
+
+static void test_arrays(void)
+{
+	jsmnreader_obj reader;
+	char json[4096];
+	unsigned int inner;
+	unsigned int i;
+
+	test_init(&reader);
+	CHECK(test_load("[1,[2,3],{\"a\":[4,{\"b\":5}]},\"s\",[],6]", &reader) == JSMN_SUCCESS);
+	test_array_agrees(0, &reader);
+	CHECK(jsmnreader_token_get_int(jsmnreader_token_array(5, 0, &reader), &reader) == 6);
+	inner = jsmnreader_token_array(1, 0, &reader);
+	test_array_agrees(inner, &reader);
+	CHECK(jsmnreader_token_get_int(jsmnreader_token_array(1, inner, &reader), &reader) == 3);
+	inner = jsmnreader_tree_get_array("a", jsmnreader_token_array(2, 0, &reader), &reader);
+	test_array_agrees(inner, &reader);
+	test_array_agrees(jsmnreader_token_array(4, 0, &reader), &reader);
+	CHECK(jsmnreader_token_array(0, jsmnreader_token_array(4, 0, &reader), &reader) == (unsigned int)-1);
+	//Not an array
+	CHECK(jsmnreader_token_array(0, jsmnreader_token_array(2, 0, &reader), &reader) == (unsigned int)-1);
+
+	//A new document at the same offsets can't be answered from the old one's tables
+	CHECK(test_load("[9,8]", &reader) == JSMN_SUCCESS);
+	test_array_agrees(0, &reader);
+	CHECK(jsmnreader_token_get_int(jsmnreader_token_array(1, 0, &reader), &reader) == 8);
+	CHECK(jsmnreader_token_array(2, 0, &reader) == (unsigned int)-1);
+
+	//Enough elements, some of them nested, to make the walk and the table differ
+	strcpy(json, "[");
+	for (i = 0; i < 60; i++)
+	{
+		sprintf(json + strlen(json), i % 3 == 0 ? "[%u,[%u]]," : i % 3 == 1 ? "{\"k\":%u,\"v\":[%u]}," : "%u,%u,", i, i);
+	}
+	strcpy(json + strlen(json) - 1, "]");
+	CHECK(test_load(json, &reader) == JSMN_SUCCESS);
+	test_array_agrees(0, &reader);
+
+	jsmnreader_free(&reader);
+}
+
+/* ---- ITERATORS ---- */
+
+static void test_iterators(void)
+{
+	static const char * keys[] = { "a", "b", "c", "e" };
+	jsmnreader_obj reader;
+	jsmnreader_iter iter;
+	unsigned int filled[8];
+	unsigned int size;
+	unsigned int next;
+	unsigned int i;
+	char buffer[8];
+
+	test_init(&reader);
+	CHECK(test_load("{\"a\":1,\"b\":[2,{\"z\":[3]},4],\"c\":{\"d\":5},\"e\":\"x\",\"f\":{}}", &reader) == JSMN_SUCCESS);
+
+	//Object items come in document order, each with its key
+	CHECK(jsmnreader_iter_init(&iter, 0, &reader) == 1);
+	for (i = 0; i < 4; i++)
+	{
+		next = jsmnreader_iter_next(&iter, &reader);
+		CHECK(next == jsmnreader_tree_get_x((char *)keys[i], 0, &reader));
+		CHECK(jsmnreader_token_copy_string(iter.key, buffer, sizeof(buffer), &reader) == 1 && strcmp(buffer, keys[i]) == 0);
+	}
+	CHECK(jsmnreader_iter_next(&iter, &reader) == jsmnreader_tree_get_x("f", 0, &reader));
+	CHECK(jsmnreader_iter_next(&iter, &reader) == (unsigned int)-1);
+	CHECK(jsmnreader_iter_next(&iter, &reader) == (unsigned int)-1);
+
+	//Array elements the same as jsmnreader_token_array_fill()
+	size = jsmnreader_token_array_fill(filled, 8, jsmnreader_tree_get_x("b", 0, &reader), &reader);
+	CHECK(size == 3);
+	CHECK(jsmnreader_iter_init(&iter, jsmnreader_tree_get_x("b", 0, &reader), &reader) == 1);
+	for (i = 0; i < size; i++)
+	{
+		CHECK(jsmnreader_iter_next(&iter, &reader) == filled[i]);
+	}
+	CHECK(jsmnreader_iter_next(&iter, &reader) == (unsigned int)-1);
+
+	//Nothing to walk
+	CHECK(jsmnreader_iter_init(&iter, jsmnreader_tree_get_x("f", 0, &reader), &reader) == 1);
+	CHECK(jsmnreader_iter_next(&iter, &reader) == (unsigned int)-1);
+	CHECK(jsmnreader_iter_init(&iter, jsmnreader_tree_get_x("a", 0, &reader), &reader) == 0);
+	CHECK(jsmnreader_iter_next(&iter, &reader) == (unsigned int)-1);
+	CHECK(jsmnreader_iter_init(&iter, (unsigned int)-1, &reader) == 0);
+	CHECK(jsmnreader_iter_next(&iter, &reader) == (unsigned int)-1);
+
+	jsmnreader_free(&reader);
+}
+
+/* ---- FILLS ---- */
+
+static void test_fills(void)
+{
+	jsmnreader_obj reader;
+	unsigned int filled[8];
+#ifndef JSMNR_NO_HEAP
+	unsigned int * tokens;
+	unsigned int tokens_size;
+#endif
+	unsigned int object;
+	unsigned int array;
+	unsigned int i;
+
+	test_init(&reader);
+	CHECK(test_load("{\"o\":{\"a\":1,\"b\":[2,3],\"c\":{\"d\":4}},\"l\":[5,{\"e\":6},[7],8],\"x\":{},\"y\":[]}", &reader) == JSMN_SUCCESS);
+	object = jsmnreader_tree_get_x("o", 0, &reader);
+	array = jsmnreader_tree_get_x("l", 0, &reader);
+
+	//Keys and values alternate, each list in document order
+	CHECK(jsmnreader_token_object_fill(filled, 8, object, JSMNR_BOTH, &reader) == 6);
+	CHECK(filled[0] == object + 1 && filled[1] == jsmnreader_tree_get_x("a", object, &reader));
+	CHECK(filled[2] == filled[1] + 1 && filled[3] == jsmnreader_tree_get_x("b", object, &reader));
+	CHECK(filled[4] == jsmnreader_tree_get_x("b\\1", object, &reader) + 1 && filled[5] == jsmnreader_tree_get_x("c", object, &reader));
+	CHECK(jsmnreader_token_object_fill(filled, 8, object, JSMNR_KEYONLY, &reader) == 3);
+	CHECK(filled[0] == object + 1 && filled[1] == jsmnreader_tree_get_x("a", object, &reader) + 1);
+	CHECK(jsmnreader_token_object_fill(filled, 8, object, JSMNR_ITEMONLY, &reader) == 3);
+	CHECK(filled[2] == jsmnreader_tree_get_x("c", object, &reader));
+	CHECK(jsmnreader_token_array_fill(filled, 8, array, &reader) == 4);
+	CHECK(filled[1] == jsmnreader_tree_get_x("l\\1", 0, &reader) && filled[3] == jsmnreader_tree_get_x("l\\3", 0, &reader));
+
+	//A short buffer still gets the full count, and nothing written past its end
+	for (i = 0; i < 8; i++)
+	{
+		filled[i] = 12345;
+	}
+	CHECK(jsmnreader_token_object_fill(filled, 3, object, JSMNR_BOTH, &reader) == 6);
+	CHECK(filled[2] == object + 3 && filled[3] == 12345);
+	CHECK(jsmnreader_token_array_fill(filled, 0, array, &reader) == 4);
+	CHECK(filled[0] == object + 1);
+
+	//Empty containers and the wrong kind of token have nothing to fill
+	CHECK(jsmnreader_token_object_fill(filled, 8, jsmnreader_tree_get_x("x", 0, &reader), JSMNR_BOTH, &reader) == 0);
+	CHECK(jsmnreader_token_array_fill(filled, 8, jsmnreader_tree_get_x("y", 0, &reader), &reader) == 0);
+	CHECK(jsmnreader_token_object_fill(filled, 8, array, JSMNR_BOTH, &reader) == 0);
+	CHECK(jsmnreader_token_array_fill(filled, 8, object, &reader) == 0);
+	CHECK(jsmnreader_token_array_fill(filled, 8, (unsigned int)-1, &reader) == 0);
+
+#ifndef JSMNR_NO_HEAP
+	//The allocating lists are sized from the container and match the fills
+	jsmnreader_token_object_tokens(&tokens, &tokens_size, object, JSMNR_BOTH, &reader);
+	CHECK(tokens_size == 6 && jsmnreader_token_object_fill(filled, 8, object, JSMNR_BOTH, &reader) == 6);
+	for (i = 0; i < 6 && i < tokens_size; i++)
+	{
+		CHECK(tokens[i] == filled[i]);
+	}
+	free(tokens);
+	jsmnreader_token_object_tokens(&tokens, &tokens_size, object, JSMNR_ITEMONLY, &reader);
+	CHECK(tokens_size == 3 && tokens[0] == jsmnreader_tree_get_x("a", object, &reader));
+	free(tokens);
+	jsmnreader_token_array_tokens(&tokens, &tokens_size, jsmnreader_tree_get_x("y", 0, &reader), &reader);
+	CHECK(tokens_size == 0);
+	free(tokens);
+#endif
+
+	jsmnreader_free(&reader);
+}
+
+/* ---- STATS ---- */
+
+#ifdef JSMNR_STATS
+static void test_stats(void)
+{
+	jsmnreader_obj reader;
+	jsmnreader_stats stats;
+	char buffer[16];
+
+	test_init(&reader);
+	jsmnreader_stats_get(&reader, &stats);
+	CHECK(stats.loads == 0 && stats.parse_passes == 0 && stats.allocations == 0 && stats.lookups == 0);
+
+	//A first load grows the tokens to the estimate, and parses once into them
+	CHECK(test_load("{\"a\":\"hello\",\"b\":[1,2]}", &reader) == JSMN_SUCCESS);
+	jsmnreader_stats_get(&reader, &stats);
+	CHECK(stats.loads == 1);
+	CHECK(stats.parse_passes == 1 && stats.bytes_parsed == 23);
+	CHECK(stats.tokens_emitted == 7);
+	CHECK(stats.estimate_misses == 0);
+#ifndef JSMNR_NO_HEAP
+	CHECK(stats.allocations + stats.reallocations >= 1);
+#endif
+	CHECK(stats.extract_calls == 0 && stats.lookups == 0);
+
+	//Each path lookup counts once, and each string copied out counts its bytes
+	CHECK(jsmnreader_tree_copy_string("a", 0, buffer, sizeof(buffer), &reader) == 5);
+	CHECK(jsmnreader_tree_get_int("b\\1", 0, &reader) == 2);
+	CHECK(jsmnreader_tree_get_x("missing", 0, &reader) == (unsigned int)-1);
+	jsmnreader_stats_get(&reader, &stats);
+	CHECK(stats.lookups == 3);
+	CHECK(stats.extract_calls == 1 && stats.extract_bytes == 5);
+	CHECK(stats.path_cache_hits + stats.path_cache_misses == 0 || stats.path_cache_misses == 3);
+
+	//Loading the same size again reuses the buffers, so nothing is allocated
+	jsmnreader_stats_reset(&reader);
+	jsmnreader_stats_get(&reader, &stats);
+	CHECK(stats.loads == 0 && stats.bytes_parsed == 0 && stats.lookups == 0 && stats.extract_bytes == 0);
+	CHECK(test_load("{\"a\":\"world\",\"b\":[3,4]}", &reader) == JSMN_SUCCESS);
+	jsmnreader_stats_get(&reader, &stats);
+	CHECK(stats.loads == 1 && stats.parse_passes == 1 && stats.tokens_emitted == 7);
+	CHECK(stats.allocations == 0 && stats.reallocations == 0);
+
+	//Failed loads still count, with the pass that found the error
+	CHECK(test_load("{\"a\":[1,2", &reader) == JSMN_ERROR_PART);
+	jsmnreader_stats_get(&reader, &stats);
+	CHECK(stats.loads == 2 && stats.parse_passes == 2 && stats.tokens_emitted == 7);
+
+	jsmnreader_free(&reader);
+}
+#endif
+
+/* ---- TRACING ---- */
+
+#ifdef JSMNR_TRACE
+//Records the hooks' calls, as "<" for a begin and ">" for an end, followed by the operation's number
+typedef struct test_trace_log_struct
+{
+	char calls[64];
+	unsigned int count;
+	jsmnreader_trace last;
+	char last_path[32];
+} test_trace_log;
+
+static void test_trace_record(test_trace_log * log, char kind, const jsmnreader_trace * trace)
+{
+	if (log->count + 2 < sizeof(log->calls))
+	{
+		log->calls[log->count++] = kind;
+		log->calls[log->count++] = (char)('0' + trace->op);
+		log->calls[log->count] = '\0';
+	}
+	log->last = *trace;
+	log->last_path[0] = '\0';
+	if (trace->path != NULL)
+		snprintf(log->last_path, sizeof(log->last_path), "%s", trace->path);
+}
+
+static void test_trace_begin(const jsmnreader_trace * trace, void * userdata)
+{
+	CHECK(trace->duration_ns == 0);
+	test_trace_record((test_trace_log *)userdata, '<', trace);
+}
+
+static void test_trace_end(const jsmnreader_trace * trace, void * userdata)
+{
+	test_trace_record((test_trace_log *)userdata, '>', trace);
+}
+
+static void test_trace(void)
+{
+	jsmnreader_obj reader;
+	test_trace_log log;
+	test_list list;
+	char buffer[8];
+
+	memset(&log, 0, sizeof(log));
+	test_init(&reader);
+	jsmnreader_trace_set(test_trace_begin, test_trace_end, &log, &reader);
+
+	//A load, with the JSON string's size and tokens in the end hook
+	CHECK(test_load("{\"a\":[1,2,3],\"b\":\"x\"}", &reader) == JSMN_SUCCESS);
+	CHECK(strcmp(log.calls, "<0>0") == 0);
+	CHECK(log.last.op == JSMNR_TRACE_LOAD && log.last.result == JSMN_SUCCESS);
+	CHECK(log.last.bytes == 21 && log.last.tokens == 8);
+	CHECK(log.last.path == NULL);
+
+	//Every path lookup, with what it found
+	log.count = 0;
+	CHECK(jsmnreader_tree_get_int("a\\2", 0, &reader) == 3);
+	CHECK(strcmp(log.calls, "<2>2") == 0);
+	CHECK(log.last.op == JSMNR_TRACE_TREE && log.last.result == 5 && strcmp(log.last_path, "a\\2") == 0);
+	CHECK(jsmnreader_tree_copy_string("b", 0, buffer, sizeof(buffer), &reader) == 1);
+	CHECK(log.last.result == 7 && log.last.offset == 0);
+	CHECK(jsmnreader_tree_get_x("c", 0, &reader) == (unsigned int)-1);
+	CHECK(log.last.result == -1);
+	memset(&list, 0, sizeof(list));
+	CHECK(jsmnreader_tree_foreach("a\\*", 0, test_collect, &list, &reader) == 3);
+	CHECK(log.last.op == JSMNR_TRACE_TREE && log.last.result == 3);
+	CHECK(strcmp(log.calls, "<2>2<2>2<2>2<2>2") == 0);
+
+	//A file load shows the load it does inside of it, and its errors
+	log.count = 0;
+	test_write_file("test_trace.json", "[true,false]");
+	CHECK(jsmnreader_fileload("test_trace.json", &reader) == JSMN_SUCCESS);
+	CHECK(strcmp(log.calls, "<1<0>0>1") == 0);
+	CHECK(log.last.op == JSMNR_TRACE_FILELOAD && strcmp(log.last_path, "test_trace.json") == 0);
+	CHECK(log.last.result == JSMN_SUCCESS && log.last.bytes == 12 && log.last.tokens == 3);
+	remove("test_trace.json");
+	log.count = 0;
+	CHECK(jsmnreader_fileload("test_trace.json", &reader) == JSMN_ERROR_NOFILE);
+	CHECK(strcmp(log.calls, "<1>1") == 0 && log.last.result == JSMN_ERROR_NOFILE);
+
+	//Either hook can be left out
+	log.count = 0;
+	jsmnreader_trace_set(NULL, test_trace_end, &log, &reader);
+	CHECK(test_load("[1]", &reader) == JSMN_SUCCESS);
+	CHECK(strcmp(log.calls, ">0") == 0);
+	log.count = 0;
+	log.calls[0] = '\0';
+	jsmnreader_trace_set(NULL, NULL, NULL, &reader);
+	CHECK(test_load("[1]", &reader) == JSMN_SUCCESS);
+	CHECK(jsmnreader_tree_get_int("0", 0, &reader) == 1);
+	CHECK(log.count == 0);
+
+	jsmnreader_free(&reader);
+}
+#endif
+
+/* ---- REUSE ---- */
+
+//Without the heap the buffers are the caller's, and never grow, shrink or change hands
+#ifndef JSMNR_NO_HEAP
+static void test_reuse(void)
+{
+	jsmnreader_obj reader;
+	char * big;
+	char * txt_buffer;
+	jsmntok_t * tokens;
+	unsigned int txt_capacity;
+	unsigned int tokens_capacity;
+	unsigned int i;
+	char borrowed[] = "[4,5]";
+
+	//Five thousand zeros, for more tokens than a load keeps once the JSON gets much smaller
+	big = (char *)malloc(10002);
+	CHECK(big != NULL);
+	if (big == NULL)
+		return;
+	big[0] = '[';
+	for (i = 0; i < 5000; i++)
+	{
+		big[i * 2 + 1] = '0';
+		big[i * 2 + 2] = ',';
+	}
+	big[10000] = ']';
+	big[10001] = '\0';
+
+	//Smaller JSON loads into the same buffers
+	test_init(&reader);
+	CHECK(test_load("{\"a\":[1,2,3,4,5,6,7,8],\"b\":\"some text\"}", &reader) == JSMN_SUCCESS);
+	txt_buffer = reader.txt_buffer;
+	tokens = reader.tokens;
+	txt_capacity = reader.txt_capacity;
+	tokens_capacity = reader.tokens_capacity;
+	CHECK(test_load("[1,2]", &reader) == JSMN_SUCCESS);
+	CHECK(reader.txt_buffer == txt_buffer && reader.tokens == tokens);
+	CHECK(reader.txt_capacity == txt_capacity && reader.tokens_capacity == tokens_capacity);
+	CHECK(jsmnreader_tree_get_int("1", 0, &reader) == 2);
+
+	//Reset empties it, still keeping the buffers
+	jsmnreader_reset(&reader);
+	CHECK(reader.txt_size == 0 && reader.tokens_count == 0);
+	CHECK(reader.txt_capacity == txt_capacity && reader.tokens_capacity == tokens_capacity);
+	CHECK(jsmnreader_tree_get_x("1", 0, &reader) == (unsigned int)-1);
+	CHECK(jsmnreader_token_get_int(0, &reader) == 0);
+	CHECK(test_load("[3]", &reader) == JSMN_SUCCESS);
+	CHECK(reader.txt_buffer == txt_buffer && reader.tokens == tokens);
+	CHECK(jsmnreader_tree_get_int("0", 0, &reader) == 3);
+
+	//Shrink sizes both buffers down to the JSON loaded
+	jsmnreader_shrink(&reader);
+	CHECK(reader.tokens_capacity == reader.tokens_count + 1);
+	CHECK(reader.txt_capacity == reader.txt_size + 1);
+	CHECK(jsmnreader_tree_get_int("0", 0, &reader) == 3);
+	CHECK(test_load("{\"a\":[1,2,3,4,5,6,7,8],\"b\":\"some text\"}", &reader) == JSMN_SUCCESS);
+	CHECK(jsmnreader_tree_get_int("a\\7", 0, &reader) == 8);
+
+	//A borrowed string leaves no text for the reader to keep
+	CHECK(jsmnreader_load_mode(borrowed, 5, JSMNR_LOAD_BORROW, &reader) == JSMN_SUCCESS);
+	jsmnreader_shrink(&reader);
+	CHECK(reader.txt_buffer == NULL && reader.txt_capacity == 0);
+	CHECK(reader.txt == borrowed && jsmnreader_tree_get_int("1", 0, &reader) == 5);
+
+	//Tokens far past what the JSON needs are given back by the next load
+	CHECK(test_load(big, &reader) == JSMN_SUCCESS);
+	CHECK(reader.tokens_count == 5001 && reader.tokens_capacity >= 5001);
+	CHECK(test_load("[1,2]", &reader) == JSMN_SUCCESS);
+	CHECK(reader.tokens_capacity < 5001);
+	CHECK(jsmnreader_tree_get_int("1", 0, &reader) == 2);
+
+	jsmnreader_free(&reader);
+	CHECK(reader.txt_buffer == NULL && reader.tokens == NULL && reader.txt_capacity == 0 && reader.tokens_capacity == 0);
+	free(big);
+}
+#endif
+
+/* ---- LOAD MODES ---- */
+
+#ifndef JSMNR_NO_HEAP
+static char * test_strdup(const char * str)
+{
+	char * copy;
+	copy = (char *)malloc(strlen(str) + 1);
+	if (copy != NULL)
+		strcpy(copy, str);
+	return copy;
+}
+
+static void test_load_modes(void)
+{
+	jsmnreader_obj reader;
+	char * owned;
+	char borrowed[] = "{\"a\":1}";
+	char copied[] = "{\"a\":2}";
+
+	test_init(&reader);
+
+	//Owned strings become the reader's text buffer, freed by the next load or jsmnreader_free()
+	owned = test_strdup("{\"a\":3}");
+	CHECK(owned != NULL && jsmnreader_load_mode(owned, 7, JSMNR_LOAD_OWN, &reader) == JSMN_SUCCESS);
+	CHECK(reader.txt == owned && reader.txt_buffer == owned);
+	CHECK(jsmnreader_tree_get_int("a", 0, &reader) == 3);
+	CHECK(jsmnreader_load_mode(owned, 7, JSMNR_LOAD_OWN, &reader) == JSMN_SUCCESS);
+	CHECK(reader.txt_buffer == owned);
+	owned = test_strdup("[4]");
+	CHECK(owned != NULL && jsmnreader_load(owned, 3, &reader) == JSMN_SUCCESS);
+	CHECK(reader.txt_buffer == owned && jsmnreader_tree_get_int("0", 0, &reader) == 4);
+
+	//Borrowed strings are parsed where they are and never freed
+	CHECK(jsmnreader_load_mode(borrowed, 7, JSMNR_LOAD_BORROW, &reader) == JSMN_SUCCESS);
+	CHECK(reader.txt == borrowed && reader.txt_buffer == owned);
+	CHECK(jsmnreader_tree_get_int("a", 0, &reader) == 1);
+
+	//Copied strings go into the reader's buffer, so the caller's can change afterwards
+	CHECK(jsmnreader_load_mode(copied, 7, JSMNR_LOAD_COPY, &reader) == JSMN_SUCCESS);
+	CHECK(reader.txt == reader.txt_buffer && reader.txt != copied);
+	copied[5] = '9';
+	CHECK(jsmnreader_tree_get_int("a", 0, &reader) == 2);
+	CHECK(reader.txt[reader.txt_size] == '\0');
+
+	//The reader's own buffer loads again in place, whatever the mode
+	CHECK(jsmnreader_load_mode(reader.txt_buffer, reader.txt_size, JSMNR_LOAD_COPY, &reader) == JSMN_SUCCESS);
+	CHECK(jsmnreader_tree_get_int("a", 0, &reader) == 2);
+	CHECK(jsmnreader_load_mode(reader.txt_buffer, reader.txt_size, JSMNR_LOAD_OWN, &reader) == JSMN_SUCCESS);
+	CHECK(jsmnreader_tree_get_int("a", 0, &reader) == 2);
+
+	//Files are read into the reader's own buffer
+	test_write_file("test_load_modes.json", "{\"a\":[5,6]}");
+	CHECK(jsmnreader_fileload("test_load_modes.json", &reader) == JSMN_SUCCESS);
+	CHECK(reader.txt == reader.txt_buffer && reader.txt_size == 11);
+	CHECK(jsmnreader_tree_get_int("a\\1", 0, &reader) == 6);
+	remove("test_load_modes.json");
+	CHECK(jsmnreader_fileload("test_load_modes.json", &reader) == JSMN_ERROR_NOFILE);
+
+	jsmnreader_free(&reader);
+	CHECK(strcmp(borrowed, "{\"a\":1}") == 0);
+}
+#endif
+
+/* ---- SUBTYPES ---- */
+
+typedef struct test_subtype_case_struct
+{
+	const char * primitive;
+	int subtype;
+} test_subtype_case;
+
+static const test_subtype_case test_subtype_cases[] = {
+	{ "null", JSMN_PRIMITIVE_NULL },
+	{ "true", JSMN_PRIMITIVE_TRUE },
+	{ "false", JSMN_PRIMITIVE_FALSE },
+	{ "0", JSMN_PRIMITIVE_INT },
+	{ "1234567890", JSMN_PRIMITIVE_INT },
+	{ "-7", JSMN_PRIMITIVE_INT | JSMN_PRIMITIVE_NEGATIVE },
+	{ "-0", JSMN_PRIMITIVE_INT | JSMN_PRIMITIVE_NEGATIVE },
+	{ "1.5", JSMN_PRIMITIVE_FLOAT },
+	{ "1e5", JSMN_PRIMITIVE_FLOAT },
+	{ "2E+10", JSMN_PRIMITIVE_FLOAT },
+	{ "-2.5e-3", JSMN_PRIMITIVE_FLOAT | JSMN_PRIMITIVE_NEGATIVE },
+	//Anything else jsmn lets through as a primitive has no subtype
+	{ "nul", 0 },
+	{ "trueish", 0 },
+	{ "1.", 0 },
+	{ "1e", 0 },
+	{ "1e+", 0 },
+	{ "-", 0 },
+	{ "12ab", 0 },
+};
+
+static void test_subtypes(void)
+{
+	jsmnreader_obj reader;
+	char json[32];
+	unsigned int i;
+
+	test_init(&reader);
+	for (i = 0; i < sizeof(test_subtype_cases) / sizeof(test_subtype_cases[0]); i++)
+	{
+		snprintf(json, sizeof(json), "[%s]", test_subtype_cases[i].primitive);
+		CHECK(test_load(json, &reader) == JSMN_SUCCESS);
+		CHECK(reader.tokens_count == 2);
+		if (jsmnreader_token_subtype(1, &reader) != test_subtype_cases[i].subtype)
+		{
+			printf("%s:%d: failed: \"%s\" gave subtype %d\n", __FILE__, __LINE__, test_subtype_cases[i].primitive, jsmnreader_token_subtype(1, &reader));
+			test_failures++;
+		}
+		CHECK(jsmnreader_token_is_null(1, &reader) == (test_subtype_cases[i].subtype == JSMN_PRIMITIVE_NULL));
+		CHECK(jsmnreader_token_is_special(1, &reader) == ((test_subtype_cases[i].subtype & (JSMN_PRIMITIVE_NULL | JSMN_PRIMITIVE_TRUE | JSMN_PRIMITIVE_FALSE)) != 0));
+	}
+
+	//Only primitives have one
+	CHECK(test_load("{\"5\":\"true\",\"a\":[]}", &reader) == JSMN_SUCCESS);
+	CHECK(jsmnreader_token_subtype(0, &reader) == 0);
+	CHECK(jsmnreader_token_subtype(1, &reader) == 0);
+	CHECK(jsmnreader_token_subtype(2, &reader) == 0 && jsmnreader_token_is_special(2, &reader) == 0);
+	CHECK(jsmnreader_token_subtype(4, &reader) == 0);
+	CHECK(jsmnreader_token_subtype(5, &reader) == 0);
+	CHECK(jsmnreader_token_subtype((unsigned int)-1, &reader) == 0);
+
+	//The getters read numbers by them, within bigger documents too
+	CHECK(test_load("{\"i\":-42,\"f\":0.25,\"t\":true,\"n\":null}", &reader) == JSMN_SUCCESS);
+	CHECK(jsmnreader_token_subtype(jsmnreader_tree_get_x("i", 0, &reader), &reader) == (JSMN_PRIMITIVE_INT | JSMN_PRIMITIVE_NEGATIVE));
+	CHECK(jsmnreader_tree_get_int("i", 0, &reader) == -42);
+	CHECK(jsmnreader_tree_get_float("f", 0, &reader) == 0.25f);
+	CHECK(jsmnreader_tree_get_int("t", 0, &reader) == 1);
+	CHECK(jsmnreader_token_is_null(jsmnreader_tree_get_x("n", 0, &reader), &reader) == 1);
+
+	jsmnreader_free(&reader);
+}
+
+/* ---- ESCAPED STRINGS ---- */
+
+static void test_escapes(void)
+{
+	jsmnreader_obj reader;
+	char buffer[16];
+#ifndef JSMNR_NO_HEAP
+	char * string;
+#endif
+	unsigned int loc;
+
+	test_init(&reader);
+	CHECK(test_load("{\"p\":\"plain \xc3\xa9 text\",\"e\":\"a\\\\b\\\"c\",\"k\\\"q\":1,\"t\":\"x\\\\\",\"n\":-5}", &reader) == JSMN_SUCCESS);
+	CHECK(reader.tokens_count == 11);
+
+	//Only strings holding an escape sequence are flagged, keys included
+	loc = jsmnreader_tree_get_x("p", 0, &reader);
+	CHECK(!((reader.tokens + loc)->subtype & JSMN_STRING_ESCAPED));
+	CHECK(!((reader.tokens + loc - 1)->subtype & JSMN_STRING_ESCAPED));
+	CHECK((reader.tokens + jsmnreader_tree_get_x("e", 0, &reader))->subtype & JSMN_STRING_ESCAPED);
+	CHECK((reader.tokens + 5)->subtype & JSMN_STRING_ESCAPED);
+	CHECK((reader.tokens + jsmnreader_tree_get_x("t", 0, &reader))->subtype & JSMN_STRING_ESCAPED);
+	CHECK(!((reader.tokens + jsmnreader_tree_get_x("n", 0, &reader))->subtype & JSMN_STRING_ESCAPED));
+
+	//Unescaped strings are copied as they are, escaped ones decoded
+	CHECK(jsmnreader_token_copy_string(loc, buffer, sizeof(buffer), &reader) == 13 && strcmp(buffer, "plain \xc3\xa9 text") == 0);
+	CHECK(jsmnreader_tree_copy_string("e", 0, buffer, sizeof(buffer), &reader) == 5 && strcmp(buffer, "a\\b\"c") == 0);
+	CHECK(jsmnreader_token_copy_string(5, buffer, sizeof(buffer), &reader) == 3 && strcmp(buffer, "k\"q") == 0);
+	CHECK(jsmnreader_tree_copy_string("t", 0, buffer, sizeof(buffer), &reader) == 2 && strcmp(buffer, "x\\") == 0);
+	CHECK(jsmnreader_tree_copy_string("e", 0, buffer, 3, &reader) == 5 && strcmp(buffer, "a\\") == 0);
+#ifndef JSMNR_NO_HEAP
+	string = jsmnreader_tree_get_string("e", 0, &reader);
+	CHECK(strcmp(string, "a\\b\"c") == 0);
+	free(string);
+	string = jsmnreader_token_get_string(loc, &reader);
+	CHECK(strcmp(string, "plain \xc3\xa9 text") == 0);
+	free(string);
+#endif
+
+	//An escaped key is matched by its decoded text, and an escaped backslash doesn't end the string early
+	CHECK(jsmnreader_tree_get_int("k\"q", 0, &reader) == 1);
+	CHECK(jsmnreader_tree_get_int("n", 0, &reader) == -5);
+
+	//The flags are worked out again for every load
+	CHECK(test_load("{\"e\":\"none\"}", &reader) == JSMN_SUCCESS);
+	CHECK(!((reader.tokens + 2)->subtype & JSMN_STRING_ESCAPED));
+	CHECK(jsmnreader_tree_copy_string("e", 0, buffer, sizeof(buffer), &reader) == 4 && strcmp(buffer, "none") == 0);
+
+	jsmnreader_free(&reader);
+}
+
+/* ---- IN-SITU ---- */
+
+static void test_insitu(void)
+{
+	static const char json[] = "{\"s\":\"a\\n\\t\\\"b\\\\n\\/\\u00e9\\ud83d\\ude00\",\"k\\u0041\":\"v\",\"n\":-12.5e1,\"t\":true,\"z\":null,\"e\":\"\",\"a\":[\"x\\u0000y\",1]}";
+	jsmnreader_obj reader;
+	jsmnreader_obj copied;
+	char borrowed[sizeof(json)];
+	char buffer[64];
+	const char * str;
+	unsigned int i;
+	int length;
+
+	test_init(&reader);
+	test_init(&copied);
+	memcpy(borrowed, json, sizeof(json));
+	CHECK(jsmnreader_load_mode(borrowed, sizeof(json) - 1, JSMNR_LOAD_BORROW, &reader) == JSMN_SUCCESS);
+	CHECK(test_load(json, &copied) == JSMN_SUCCESS);
+	CHECK(jsmnreader_token_get_insitu(1, &reader) == NULL);
+
+	//Twice is the same as once
+	jsmnreader_insitu(&reader);
+	jsmnreader_insitu(&reader);
+	CHECK(reader.tokens_count == copied.tokens_count);
+	for (i = 0; i < reader.tokens_count && i < copied.tokens_count; i++)
+	{
+		str = jsmnreader_token_get_insitu(i, &reader);
+		length = jsmnreader_token_copy_string(i, buffer, sizeof(buffer), &copied);
+		if ((copied.tokens + i)->type == JSMN_OBJECT || (copied.tokens + i)->type == JSMN_ARRAY)
+		{
+			CHECK(str == NULL);
+			continue;
+		}
+		//Decoded the same as the copying getters, within the borrowed string
+		CHECK(str != NULL && length >= 0 && length < (int)sizeof(buffer));
+		CHECK(str != NULL && str >= borrowed && str < borrowed + sizeof(borrowed));
+		CHECK(str != NULL && memcmp(str, buffer, length + 1) == 0);
+	}
+	//Only '\\' and '"' escapes are kept, the same as jsmnreader_token_get_string() has always done
+	CHECK(strcmp(jsmnreader_tree_get_insitu("s", 0, &reader), "a\"b\\n00e9d83dde00") == 0);
+	CHECK(strcmp(jsmnreader_tree_get_insitu("n", 0, &reader), "-12.5e1") == 0);
+	CHECK(strcmp(jsmnreader_tree_get_insitu("t", 0, &reader), "true") == 0);
+	CHECK(strcmp(jsmnreader_tree_get_insitu("e", 0, &reader), "") == 0);
+	CHECK(jsmnreader_tree_get_insitu("a", 0, &reader) == NULL);
+	CHECK(jsmnreader_tree_get_insitu("missing", 0, &reader) == NULL);
+	CHECK(jsmnreader_token_get_insitu(reader.tokens_count, &reader) == NULL);
+
+	//A new load starts over undecoded
+	CHECK(test_load("[\"\\\\\\\"\"]", &reader) == JSMN_SUCCESS);
+	CHECK(jsmnreader_token_get_insitu(1, &reader) == NULL);
+	jsmnreader_insitu(&reader);
+	CHECK(strcmp(jsmnreader_token_get_insitu(1, &reader), "\\\"") == 0);
+
+	jsmnreader_free(&reader);
+	jsmnreader_free(&copied);
+}
+
+/* ---- VALIDATION ---- */
+
+typedef struct test_validate_case_struct
+{
+	const char * json;
+	int result;
+	unsigned int error_pos;
+} test_validate_case;
+
+static const test_validate_case test_validate_cases[] = {
+	{ "{\"a\":[1,-2.5e+3,true,false,null,\"x\"]}", JSMN_SUCCESS, 37 },
+	{ " 1 ", JSMN_SUCCESS, 3 },
+	{ "\"\\u00e9\\n\\/\"", JSMN_SUCCESS, 12 },
+	{ "\"\xc3\xa9\xf0\x9f\x98\x80\"", JSMN_SUCCESS, 8 },
+	{ "[[],{}]", JSMN_SUCCESS, 7 },
+	{ "[1,]", JSMN_ERROR_INVAL, 3 },
+	{ "{\"a\":1,}", JSMN_ERROR_INVAL, 7 },
+	{ "01", JSMN_ERROR_INVAL, 1 },
+	{ ".5", JSMN_ERROR_INVAL, 0 },
+	{ "truex", JSMN_ERROR_INVAL, 4 },
+	{ "[1 2]", JSMN_ERROR_INVAL, 3 },
+	{ "1 2", JSMN_ERROR_INVAL, 2 },
+	{ "{\"a\" 1}", JSMN_ERROR_INVAL, 5 },
+	{ "{1:2}", JSMN_ERROR_INVAL, 1 },
+	{ "[1]]", JSMN_ERROR_INVAL, 3 },
+	{ "\"a\tb\"", JSMN_ERROR_INVAL, 2 },
+	{ "\"\\x\"", JSMN_ERROR_INVAL, 2 },
+	{ "\"\\u12g4\"", JSMN_ERROR_INVAL, 5 },
+	{ "\"\xc3\x28\"", JSMN_ERROR_INVAL, 1 },
+	{ "\"\xed\xa0\x80\"", JSMN_ERROR_INVAL, 1 },
+	{ "\"\xc0\xaf\"", JSMN_ERROR_INVAL, 1 },
+	{ "", JSMN_ERROR_PART, 0 },
+	{ "  ", JSMN_ERROR_PART, 2 },
+	{ "[1", JSMN_ERROR_PART, 2 },
+	{ "{\"a\":", JSMN_ERROR_PART, 5 },
+	{ "\"abc", JSMN_ERROR_PART, 4 },
+	{ "1.", JSMN_ERROR_PART, 2 },
+	{ "tru", JSMN_ERROR_PART, 3 },
+};
+
+static void test_validate(void)
+{
+	jsmnreader_obj reader;
+	char * json;
+	unsigned int error_pos;
+	unsigned int i;
+
+	for (i = 0; i < sizeof(test_validate_cases) / sizeof(test_validate_cases[0]); i++)
+	{
+		error_pos = 0;
+		if (jsmnreader_validate(test_validate_cases[i].json, (unsigned int)strlen(test_validate_cases[i].json), &error_pos) != test_validate_cases[i].result || error_pos != test_validate_cases[i].error_pos)
+		{
+			printf("%s:%d: failed: jsmnreader_validate(\"%s\") gave error_pos %u\n", __FILE__, __LINE__, test_validate_cases[i].json, error_pos);
+			test_failures++;
+		}
+	}
+	CHECK(jsmnreader_validate("[1]", 3, NULL) == JSMN_SUCCESS);
+
+	//As deep as allowed, then one deeper, for both the validator and the parser
+	json = (char *)malloc(2 * (JSMNR_MAX_DEPTH + 1) + 1);
+	memset(json, '[', JSMNR_MAX_DEPTH);
+	memset(json + JSMNR_MAX_DEPTH, ']', JSMNR_MAX_DEPTH);
+	json[2 * JSMNR_MAX_DEPTH] = '\0';
+	test_init(&reader);
+	CHECK(jsmnreader_validate(json, 2 * JSMNR_MAX_DEPTH, &error_pos) == JSMN_SUCCESS);
+	CHECK(test_load(json, &reader) == JSMN_SUCCESS);
+	memset(json, '[', JSMNR_MAX_DEPTH + 1);
+	memset(json + JSMNR_MAX_DEPTH + 1, ']', JSMNR_MAX_DEPTH + 1);
+	json[2 * (JSMNR_MAX_DEPTH + 1)] = '\0';
+	CHECK(jsmnreader_validate(json, 2 * (JSMNR_MAX_DEPTH + 1), &error_pos) == JSMN_ERROR_DEPTH);
+	CHECK(error_pos == JSMNR_MAX_DEPTH);
+	CHECK(test_load(json, &reader) == JSMN_ERROR_DEPTH);
+	jsmnreader_free(&reader);
+	free(json);
+}
+
+/* ---- UTF-8 ---- */
+
+//The same fixed sequence on every run, so a failure can be reproduced
+static unsigned int test_random_state = 2463534242u;
+
+static unsigned int test_random(void)
+{
+	test_random_state ^= test_random_state << 13;
+	test_random_state ^= test_random_state >> 17;
+	test_random_state ^= test_random_state << 5;
+	return test_random_state;
+}
+
+//What jsmnreader_utf8_validate() has to give, one character at a time
+static int test_utf8_scalar(const unsigned char * s, unsigned int size, unsigned int * error_pos)
+{
+	unsigned int pos;
+	int n;
+	pos = 0;
+	while (pos < size)
+	{
+		n = jsmnreader_utf8_check(s + pos, size - pos);
+		if (n <= 0)
+		{
+			*error_pos = pos;
+			return (n < 0) ? JSMN_ERROR_PART : JSMN_ERROR_INVAL;
+		}
+		pos += n;
+	}
+	*error_pos = size;
+	return JSMN_SUCCESS;
+}
+
+//Mostly valid text, with runs of ASCII and the edges of each range, so the errors land anywhere in a block
+static unsigned int test_utf8_fill(unsigned char * s, unsigned int capacity)
+{
+	static const unsigned char edges[][4] = {
+		{ 0xC2, 0x80 }, { 0xDF, 0xBF }, { 0xE0, 0xA0, 0x80 }, { 0xED, 0x9F, 0xBF }, { 0xEF, 0xBF, 0xBF },
+		{ 0xF0, 0x90, 0x80, 0x80 }, { 0xF4, 0x8F, 0xBF, 0xBF },
+		{ 0xC0, 0x80 }, { 0xC1, 0xBF }, { 0xE0, 0x9F, 0xBF }, { 0xED, 0xA0, 0x80 }, { 0xF0, 0x8F, 0xBF, 0xBF }, { 0xF4, 0x90, 0x80, 0x80 }, { 0xF5, 0x80, 0x80, 0x80 }, { 0xFF },
+	};
+	unsigned int size;
+	unsigned int code;
+	unsigned int n;
+	unsigned int i;
+	size = 0;
+	while (size + 4 <= capacity)
+	{
+		switch (test_random() % 8)
+		{
+		case 0:
+		case 1:
+		case 2:
+			n = test_random() % 40;
+			for (i = 0; i < n && size < capacity; i++)
+				s[size++] = (unsigned char)(0x20 + test_random() % 0x5F);
+			break;
+		case 3:
+			code = 0x80 + test_random() % 0x780;
+			s[size++] = (unsigned char)(0xC0 | (code >> 6));
+			s[size++] = (unsigned char)(0x80 | (code & 0x3F));
+			break;
+		case 4:
+			code = 0x800 + test_random() % 0xF800;
+			if (code >= 0xD800 && code < 0xE000)
+				code -= 0x800;
+			s[size++] = (unsigned char)(0xE0 | (code >> 12));
+			s[size++] = (unsigned char)(0x80 | ((code >> 6) & 0x3F));
+			s[size++] = (unsigned char)(0x80 | (code & 0x3F));
+			break;
+		case 5:
+			code = 0x10000 + test_random() % 0x100000;
+			s[size++] = (unsigned char)(0xF0 | (code >> 18));
+			s[size++] = (unsigned char)(0x80 | ((code >> 12) & 0x3F));
+			s[size++] = (unsigned char)(0x80 | ((code >> 6) & 0x3F));
+			s[size++] = (unsigned char)(0x80 | (code & 0x3F));
+			break;
+		case 6:
+			n = test_random() % (sizeof(edges) / sizeof(edges[0]));
+			for (i = 0; i < 4 && (i == 0 || edges[n][i] != 0); i++)
+				s[size++] = edges[n][i];
+			break;
+		default:
+			//Rarely a byte from anywhere
+			if (test_random() % 8 == 0)
+				s[size++] = (unsigned char)test_random();
+			break;
+		}
+	}
+	return size;
+}
+
+static void test_utf8(void)
+{
+	unsigned char s[512];
+	unsigned int size;
+	unsigned int cut;
+	unsigned int expected_pos;
+	unsigned int error_pos;
+	unsigned int failed;
+	unsigned int i;
+	int expected;
+	int result;
+
+	failed = 0;
+	for (i = 0; i < 20000; i++)
+	{
+		size = test_utf8_fill(s, 4 + test_random() % (sizeof(s) - 3));
+		//Half of them cut short anywhere, to end partway through a character
+		cut = (i % 2) ? test_random() % (size + 1) : size;
+		expected = test_utf8_scalar(s, cut, &expected_pos);
+		error_pos = (unsigned int)-1;
+		result = jsmnreader_utf8_validate((const char *)s, cut, &error_pos);
+		if ((result != expected || error_pos != expected_pos) && failed++ < 10)
+		{
+			printf("%s:%d: failed: jsmnreader_utf8_validate() on input %u gave %d at %u, expected %d at %u\n", __FILE__, __LINE__, i, result, error_pos, expected, expected_pos);
+			test_failures++;
+		}
+	}
+	CHECK(jsmnreader_utf8_validate("", 0, &error_pos) == JSMN_SUCCESS && error_pos == 0);
+	CHECK(jsmnreader_utf8_validate("\xc3", 1, NULL) == JSMN_ERROR_PART);
+}
+
+/* ---- SKIPPING ---- */
+
+//Appends a random value nested up to 'depth' more levels, with brackets inside some of its strings
+static void test_random_value(char * json, unsigned int * size, unsigned int capacity, unsigned int depth)
+{
+	unsigned int count;
+	unsigned int i;
+	unsigned int kind;
+	kind = (depth > 0 && *size + 1024 < capacity) ? test_random() % 6 : 2 + test_random() % 4;
+	if (kind < 2)
+	{
+		json[(*size)++] = (kind == 0) ? '[' : '{';
+		count = test_random() % 6;
+		for (i = 0; i < count; i++)
+		{
+			if (i > 0)
+				json[(*size)++] = ',';
+			if (kind == 1)
+				*size += sprintf(json + *size, "\"k%u\":", i);
+			test_random_value(json, size, capacity, depth - 1);
+		}
+		json[(*size)++] = (kind == 0) ? ']' : '}';
+	}
+	else if (kind == 2)
+		*size += sprintf(json + *size, "%u", test_random() % 1000);
+	else if (kind == 3)
+		*size += sprintf(json + *size, "\"[{%u\\\"}]\"", test_random() % 10);
+	else if (kind == 4)
+		*size += sprintf(json + *size, "\"s\"");
+	else
+		*size += sprintf(json + *size, "null");
+	json[*size] = '\0';
+}
+
+//How many tokens the value at 'index' takes up, counted one by one through the sizes
+static unsigned int test_span(unsigned int index, jsmnreader_obj * reader)
+{
+	unsigned int next;
+	int i;
+	next = index + 1;
+	for (i = 0; i < (reader->tokens + index)->size; i++)
+	{
+		next += test_span(next, reader);
+	}
+	return next - index;
+}
+
+static void test_dataskip(void)
+{
+	jsmnreader_obj reader;
+	jsmnreader_iter iter;
+	jsmn_parser parser;
+	jsmntok_t tokens[4];
+	char * json;
+	unsigned int size;
+	unsigned int next;
+	unsigned int round;
+	unsigned int t;
+	int i;
+
+	json = (char *)malloc(2 * (JSMNR_MAX_DEPTH + 1) + 32);
+	CHECK(json != NULL);
+	if (json == NULL)
+		return;
+	test_init(&reader);
+
+	//Every item of every container is found past the one before, however much it holds
+	for (round = 0; round < 200; round++)
+	{
+		size = 1;
+		json[0] = '[';
+		test_random_value(json, &size, 2 * (JSMNR_MAX_DEPTH + 1), 1 + round % 8);
+		json[size++] = ']';
+		json[size] = '\0';
+		CHECK(test_load(json, &reader) == JSMN_SUCCESS);
+		CHECK(test_span(0, &reader) == reader.tokens_count);
+		for (t = 0; t < reader.tokens_count; t++)
+		{
+			if (!jsmnreader_iter_init(&iter, t, &reader))
+				continue;
+			next = t + 1;
+			for (i = 0; i < (reader.tokens + t)->size; i++)
+			{
+				if ((reader.tokens + t)->type == JSMN_OBJECT)
+				{
+					CHECK(jsmnreader_iter_next(&iter, &reader) == next + 1 && iter.key == next);
+				}
+				else
+				{
+					CHECK(jsmnreader_iter_next(&iter, &reader) == next);
+					CHECK(jsmnreader_token_array(i, t, &reader) == next);
+				}
+				next += test_span(next, &reader);
+			}
+			CHECK(jsmnreader_iter_next(&iter, &reader) == (unsigned int)-1);
+		}
+	}
+
+	//Keys after a value as deep as allowed
+	size = (unsigned int)sprintf(json, "{\"a\":");
+	memset(json + size, '[', JSMNR_MAX_DEPTH - 1);
+	memset(json + size + JSMNR_MAX_DEPTH - 1, ']', JSMNR_MAX_DEPTH - 1);
+	size += 2 * (JSMNR_MAX_DEPTH - 1);
+	sprintf(json + size, ",\"b\":7}");
+	CHECK(test_load(json, &reader) == JSMN_SUCCESS);
+	CHECK(reader.tokens_count == JSMNR_MAX_DEPTH + 3);
+	CHECK(jsmnreader_tree_get_int("b", 0, &reader) == 7);
+	CHECK(jsmnreader_token_size(0, &reader) == 2);
+
+	//jsmn_parse() stops one level past JSMNR_MAX_DEPTH whether it's counting tokens or making them, and only nesting counts
+	memset(json, '[', JSMNR_MAX_DEPTH);
+	memset(json + JSMNR_MAX_DEPTH, ']', JSMNR_MAX_DEPTH);
+	jsmn_init(&parser);
+	CHECK(jsmn_parse(&parser, json, 2 * JSMNR_MAX_DEPTH, NULL, 0, 1) == JSMNR_MAX_DEPTH);
+	CHECK(parser.depth == 0);
+	memset(json, '[', JSMNR_MAX_DEPTH + 1);
+	memset(json + JSMNR_MAX_DEPTH + 1, ']', JSMNR_MAX_DEPTH + 1);
+	jsmn_init(&parser);
+	CHECK(jsmn_parse(&parser, json, 2 * (JSMNR_MAX_DEPTH + 1), NULL, 0, 1) == JSMN_ERROR_DEPTH);
+	CHECK(parser.pos == JSMNR_MAX_DEPTH);
+	jsmn_init(&parser);
+	CHECK(jsmn_parse(&parser, json, 2 * (JSMNR_MAX_DEPTH + 1), tokens, 4, 0) == JSMN_ERROR_NOMEM);
+	json[0] = '[';
+	for (t = 0; t < JSMNR_MAX_DEPTH; t++)
+	{
+		json[t * 2 + 1] = '[';
+		json[t * 2 + 2] = ']';
+	}
+	json[2 * JSMNR_MAX_DEPTH + 1] = ']';
+	jsmn_init(&parser);
+	CHECK(jsmn_parse(&parser, json, 2 * (JSMNR_MAX_DEPTH + 1), NULL, 0, 1) == JSMNR_MAX_DEPTH + 1);
+
+	jsmnreader_free(&reader);
+	free(json);
+}
+
+/* ---- WITHOUT THE HEAP ---- */
+
+#ifdef JSMNR_NO_HEAP
+static void test_no_heap(void)
+{
+	static const char json[] = "{\"a\":[1,2],\"b\":\"x\\\"y\"}";
+	jsmnreader_obj reader;
+	jsmnreader_iter iter;
+	jsmntok_t tokens[7];
+	char txt[24];
+	char borrowed[] = "[1,2,3,4,5,6,7]";
+	char buffer[8];
+	unsigned int filled[4];
+
+	//Exactly the tokens and text the estimate asks for is enough
+	CHECK(jsmnreader_token_estimate(json, sizeof(json) - 1) == 7);
+	jsmnreader_init_buffers(tokens, 7, txt, sizeof(json), &reader);
+	CHECK(test_load(json, &reader) == JSMN_SUCCESS);
+	CHECK(reader.tokens == tokens && reader.txt == txt && reader.tokens_count == 7);
+	CHECK(jsmnreader_tree_get_int("a\\1", 0, &reader) == 2);
+	CHECK(jsmnreader_tree_copy_string("b", 0, buffer, sizeof(buffer), &reader) == 3 && strcmp(buffer, "x\"y") == 0);
+	CHECK(jsmnreader_iter_init(&iter, jsmnreader_tree_get_x("a", 0, &reader), &reader) == 1);
+	CHECK(jsmnreader_iter_next(&iter, &reader) == 3 && jsmnreader_iter_next(&iter, &reader) == 4);
+	CHECK(jsmnreader_token_object_fill(filled, 4, 0, JSMNR_KEYONLY, &reader) == 2 && filled[1] == 5);
+	jsmnreader_insitu(&reader);
+	CHECK(strcmp(jsmnreader_tree_get_insitu("b", 0, &reader), "x\"y") == 0);
+
+	//Any more is JSMN_ERROR_NOMEM, leaving the reader empty but usable
+	CHECK(test_load("{\"a\":[1,2],\"b\":\"x\\\"yz\"}", &reader) == JSMN_ERROR_NOMEM);
+	CHECK(reader.tokens_count == 0 && jsmnreader_tree_get_x("a", 0, &reader) == (unsigned int)-1);
+	CHECK(jsmnreader_load_mode(borrowed, 15, JSMNR_LOAD_BORROW, &reader) == JSMN_ERROR_NOMEM);
+	CHECK(reader.tokens_count == 0);
+	CHECK(jsmnreader_load_mode(borrowed, 13, JSMNR_LOAD_BORROW, &reader) == JSMN_ERROR_PART);
+	borrowed[12] = ']';
+	CHECK(jsmnreader_load_mode(borrowed, 13, JSMNR_LOAD_BORROW, &reader) == JSMN_SUCCESS);
+	CHECK(reader.tokens == tokens && reader.txt == borrowed);
+	CHECK(jsmnreader_tree_get_int("5", 0, &reader) == 6);
+
+	//Owned strings are only borrowed, as there's nothing to free them with
+	CHECK(jsmnreader_load_mode(borrowed, 13, JSMNR_LOAD_OWN, &reader) == JSMN_SUCCESS);
+	CHECK(reader.txt == borrowed && reader.txt_buffer == txt);
+
+	//File loads read into the text buffer, which has to fit the file and its '\0'
+	test_write_file("test_no_heap.json", json);
+	CHECK(jsmnreader_fileload("test_no_heap.json", &reader) == JSMN_SUCCESS);
+	CHECK(reader.txt == txt && jsmnreader_tree_get_int("a\\0", 0, &reader) == 1);
+	test_write_file("test_no_heap.json", "[1,2,3,4,5,6,7,8,9,10,11]");
+	CHECK(jsmnreader_fileload("test_no_heap.json", &reader) == JSMN_ERROR_NOMEM);
+	remove("test_no_heap.json");
+
+	//Shrinking and freeing never touch the caller's buffers
+	jsmnreader_init_buffers(tokens, 7, NULL, 0, &reader);
+	CHECK(test_load("[1]", &reader) == JSMN_ERROR_NOMEM);
+	CHECK(jsmnreader_load_mode(borrowed, 13, JSMNR_LOAD_BORROW, &reader) == JSMN_SUCCESS);
+	jsmnreader_shrink(&reader);
+	CHECK(reader.tokens == tokens && reader.tokens_capacity == 7);
+	jsmnreader_free(&reader);
+	CHECK(reader.tokens == NULL && reader.tokens_capacity == 0);
+	CHECK(tokens[6].type == JSMN_PRIMITIVE && tokens[6].start == 11);
+}
+#endif
+
+/* ---- TOKEN ESTIMATE ---- */
+
+//Loads 'json' into a new reader, returning whether jsmnreader_load() had to fall back to counting the tokens (always 0 without JSMNR_STATS)
+static unsigned int test_load_fresh(const char * json, jsmnreader_obj * reader)
+{
+#ifdef JSMNR_STATS
+	jsmnreader_stats stats;
+#endif
+	test_init(reader);
+	CHECK(test_load(json, reader) == JSMN_SUCCESS);
+#ifdef JSMNR_STATS
+	jsmnreader_stats_get(reader, &stats);
+	return (unsigned int)stats.estimate_misses;
+#else
+	return 0;
+#endif
+}
+
+static void test_estimate(void)
+{
+	static const char * fitting[] = {
+		"{\"a\":[1,-2.5e+3,true,false,null,\"x\"]}",
+		"[[],{},[[]],{\"a\":{}}]",
+		"{ \"a\" : [ 1 , 2 ] , \"b\" : \"c, d: [e]\" }",
+		"\"s\"",
+		"[]",
+	};
+	jsmnreader_obj reader;
+#ifdef JSMNR_STATS
+	jsmnreader_stats stats;
+#endif
+	unsigned int i;
+
+	//Well-formed documents never make more tokens than estimated
+	for (i = 0; i < sizeof(fitting) / sizeof(fitting[0]); i++)
+	{
+		CHECK(test_load_fresh(fitting[i], &reader) == 0);
+		CHECK(reader.tokens_count <= jsmnreader_token_estimate(fitting[i], (unsigned int)strlen(fitting[i])));
+		jsmnreader_free(&reader);
+	}
+
+	//Whitespace between primitives or more than one value at the top go past it, and still load whole
+	CHECK(jsmnreader_token_estimate("[1 2 3 4 5 6 7 8]", 17) == 2);
+	CHECK(test_load_fresh("[1 2 3 4 5 6 7 8]", &reader) <= 1);
+	CHECK(reader.tokens_count == 9);
+	for (i = 0; i < 8; i++)
+	{
+		CHECK(jsmnreader_token_get_int(jsmnreader_token_array(i, 0, &reader), &reader) == (int)i + 1);
+	}
+	jsmnreader_free(&reader);
+#if defined(JSMNR_STATS) && !defined(JSMNR_NO_HEAP)
+	CHECK(test_load_fresh("[1 2 3 4 5 6 7 8]", &reader) == 1);
+	jsmnreader_free(&reader);
+#endif
+
+	CHECK(test_load_fresh("\"a\" \"b\" {\"c\":[1,2]} ", &reader) <= 1);
+	CHECK(reader.tokens_count == 7);
+	CHECK(jsmnreader_tree_get_int("c\\1", 2, &reader) == 2);
+	//Loaded again into the tokens it grew to, there's nothing left to count
+#ifdef JSMNR_STATS
+	jsmnreader_stats_reset(&reader);
+#endif
+	CHECK(test_load("[1 2 3 4]", &reader) == JSMN_SUCCESS);
+	CHECK(reader.tokens_count == 5);
+#ifdef JSMNR_STATS
+	jsmnreader_stats_get(&reader, &stats);
+	CHECK(stats.estimate_misses == 0 && stats.parse_passes == 1);
+#endif
+	CHECK(jsmnreader_token_get_int(jsmnreader_token_array(3, 0, &reader), &reader) == 4);
+	jsmnreader_free(&reader);
+}
+
+/* ---- PATH CACHE ---- */
+
+static void test_path_cache(void)
+{
+	jsmnreader_obj reader;
+#if defined(JSMNR_STATS) && defined(JSMNR_PATH_CACHE)
+	jsmnreader_stats stats;
+#endif
+	char json[8192];
+	char path[16];
+	unsigned int i;
+
+	test_init(&reader);
+	CHECK(test_load("{\"a\":{\"b\":1},\"c\":2}", &reader) == JSMN_SUCCESS);
+	CHECK(jsmnreader_tree_get_int("a\\b", 0, &reader) == 1);
+	CHECK(jsmnreader_tree_get_int("a\\b", 0, &reader) == 1);
+	CHECK(jsmnreader_tree_get_int("b", jsmnreader_tree_get_x("a", 0, &reader), &reader) == 1);
+#if defined(JSMNR_STATS) && defined(JSMNR_PATH_CACHE)
+	jsmnreader_stats_get(&reader, &stats);
+	CHECK(stats.path_cache_hits == 1);
+#endif
+
+	//Each load answers from its own document, wherever the old one's tokens were
+	CHECK(test_load("{\"c\":3,\"a\":{\"x\":0,\"b\":4}}", &reader) == JSMN_SUCCESS);
+	CHECK(jsmnreader_tree_get_int("a\\b", 0, &reader) == 4);
+	CHECK(jsmnreader_tree_get_int("c", 0, &reader) == 3);
+	CHECK(test_load("{\"c\":5}", &reader) == JSMN_SUCCESS);
+	CHECK(jsmnreader_tree_get_x("a\\b", 0, &reader) == (unsigned int)-1);
+	CHECK(jsmnreader_tree_get_int("c", 0, &reader) == 5);
+	jsmnreader_reset(&reader);
+	CHECK(jsmnreader_tree_get_x("c", 0, &reader) == (unsigned int)-1);
+	CHECK(test_load("{\"a\":{\"b\":6}}", &reader) == JSMN_SUCCESS);
+	CHECK(jsmnreader_tree_get_int("a\\b", 0, &reader) == 6);
+
+	//More paths than the cache holds, each looked up twice
+	strcpy(json, "{");
+	for (i = 0; i < 400; i++)
+	{
+		sprintf(json + strlen(json), "\"k%u\":%u,", i, i * 3);
+	}
+	strcpy(json + strlen(json) - 1, "}");
+	CHECK(test_load(json, &reader) == JSMN_SUCCESS);
+	for (i = 0; i < 800; i++)
+	{
+		sprintf(path, "k%u", i % 400);
+		CHECK(jsmnreader_tree_get_int(path, 0, &reader) == (int)(i % 400) * 3);
+	}
+	CHECK(jsmnreader_tree_get_x("k400", 0, &reader) == (unsigned int)-1);
+
+	jsmnreader_free(&reader);
+}
+
+/* ---- COLUMNS ---- */
+
+static void test_columns(void)
+{
+	static const char json[] = "[{\"id\":1,\"name\":\"a\\\\\\\"b\",\"score\":2.5},{\"name\":\"x\",\"id\":-7},{\"id\":1e5,\"score\":\"n/a\",\"name\":true},{\"other\":1},5,"
+		"{\"id\":99999999999999999999,\"score\":1e400,\"name\":null},{\"id\":-2.9,\"score\":-0.5,\"name\":12},{\"id\":9223372036854775807,\"score\":0.1,\"name\":\"\"}]";
+	static const long long ids[8] = { 1, -7, 100000, 0, 0, 0, -2, 9223372036854775807LL };
+	static const unsigned char ids_found[8] = { 1, 1, 1, 0, 0, 0, 1, 1 };
+	static const double scores[8] = { 2.5, 0, 0, 0, 0, 0, -0.5, 0.1 };
+	static const unsigned char scores_found[8] = { 1, 0, 0, 0, 0, 0, 1, 1 };
+	static const char * names[8] = { "a\\\"b", "x", "true", NULL, NULL, "null", "12", "" };
+	jsmnreader_obj reader;
+	jsmnreader_column columns[3];
+	long long id_values[8];
+	double score_values[8];
+	unsigned int name_values[8];
+	unsigned char found[3][8];
+	char arena[64];
+	char buffer[64];
+	unsigned int arena_used;
+	unsigned int row;
+	unsigned int index;
+
+	test_init(&reader);
+	CHECK(test_load(json, &reader) == JSMN_SUCCESS);
+	columns[0].key = "id";
+	columns[0].type = JSMNR_COLUMN_INT64;
+	columns[0].values = id_values;
+	columns[0].found = found[0];
+	columns[1].key = "score";
+	columns[1].type = JSMNR_COLUMN_DOUBLE;
+	columns[1].values = score_values;
+	columns[1].found = found[1];
+	columns[2].key = "name";
+	columns[2].type = JSMNR_COLUMN_STRING;
+	columns[2].values = name_values;
+	columns[2].found = found[2];
+
+	CHECK(jsmnreader_token_array_columns(columns, 3, 8, arena, sizeof(arena), &arena_used, 0, &reader) == 8);
+	CHECK(arena_used == 21);
+	for (row = 0; row < 8; row++)
+	{
+		CHECK(id_values[row] == ids[row] && found[0][row] == ids_found[row]);
+		CHECK(score_values[row] == scores[row] && found[1][row] == scores_found[row]);
+		CHECK(found[2][row] == (names[row] != NULL));
+		CHECK(names[row] == NULL ? name_values[row] == (unsigned int)-1 : (name_values[row] < sizeof(arena) && strcmp(arena + name_values[row], names[row]) == 0));
+
+		//The same as the per-token getters, where they read the same
+		index = jsmnreader_tree_get_x("id", jsmnreader_token_array(row, 0, &reader), &reader);
+		if (found[0][row] && ((reader.tokens + index)->subtype & JSMN_PRIMITIVE_INT) && id_values[row] >= -2147483647 && id_values[row] <= 2147483647)
+		{
+			CHECK(id_values[row] == jsmnreader_token_get_int(index, &reader));
+		}
+		index = jsmnreader_tree_get_x("score", jsmnreader_token_array(row, 0, &reader), &reader);
+		if (found[1][row])
+		{
+			CHECK(jsmnreader_token_copy_string(index, buffer, sizeof(buffer), &reader) > 0 && score_values[row] == strtod(buffer, NULL));
+		}
+		index = jsmnreader_tree_get_x("name", jsmnreader_token_array(row, 0, &reader), &reader);
+		if (found[2][row])
+		{
+			CHECK(jsmnreader_token_copy_string(index, buffer, sizeof(buffer), &reader) >= 0 && strcmp(arena + name_values[row], buffer) == 0);
+		}
+	}
+	//Exponents are applied, where jsmnreader_token_get_int() stops at the 'e'
+	CHECK(jsmnreader_tree_get_int("2\\id", 0, &reader) == 1);
+
+	//Fewer rows than items, and an arena too small for all the strings
+	memset(id_values, 0x55, sizeof(id_values));
+	CHECK(jsmnreader_token_array_columns(columns, 3, 3, arena, 6, &arena_used, 0, &reader) == 8);
+	CHECK(arena_used == 12);
+	CHECK(id_values[2] == 100000 && id_values[3] == 0x5555555555555555LL);
+	CHECK(name_values[0] == 0 && strcmp(arena, "a\\\"b") == 0);
+	CHECK(name_values[1] == (unsigned int)-1 && found[2][1] == 1);
+	CHECK(name_values[2] == (unsigned int)-1 && found[2][2] == 1);
+
+	//Not an array
+	CHECK(jsmnreader_token_array_columns(columns, 3, 8, arena, sizeof(arena), &arena_used, 1, &reader) == 0);
+	CHECK(arena_used == 0);
+
+	jsmnreader_free(&reader);
+}
+
+/* ---- BULK NUMBERS ---- */
+
+static void test_numbers(void)
+{
+	static const char json[] = "[0,-0,1,-1,2147483647,-2147483648,1.5,-2.5,1e5,1E-3,0.1,2147483648,\"7\",true,9223372036854775807,-9223372036854775809,3.4028235e38,3.5e38,1e400]";
+	static const int ints[19] = { 0, 0, 1, -1, 2147483647, -2147483647 - 1, 1, -2, 100000, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+	static const long long longs[19] = { 0, 0, 1, -1, 2147483647, -2147483647 - 1, 1, -2, 100000, 0, 0, 2147483648LL, 0, 0, 9223372036854775807LL, 0, 0, 0, 0 };
+	jsmnreader_obj reader;
+	int int_values[19];
+	long long long_values[19];
+	float float_values[19];
+	double double_values[19];
+	char buffer[64];
+	char * json_random;
+	float * random_floats;
+	double * random_doubles;
+	unsigned int error_index;
+	unsigned int size;
+	unsigned int index;
+	unsigned int mismatches;
+	unsigned int i;
+	unsigned int k;
+
+	test_init(&reader);
+	CHECK(test_load(json, &reader) == JSMN_SUCCESS);
+	CHECK(jsmnreader_token_array_get_int32(int_values, 19, &error_index, 0, &reader) == 19);
+	CHECK(error_index == 11);
+	CHECK(memcmp(int_values, ints, sizeof(ints)) == 0);
+	CHECK(jsmnreader_token_array_get_int64(long_values, 19, &error_index, 0, &reader) == 19);
+	CHECK(error_index == 12);
+	CHECK(memcmp(long_values, longs, sizeof(longs)) == 0);
+	CHECK(jsmnreader_token_array_get_float(float_values, 19, &error_index, 0, &reader) == 19);
+	CHECK(error_index == 12);
+	CHECK(jsmnreader_token_array_get_double(double_values, 19, &error_index, 0, &reader) == 19);
+	CHECK(error_index == 12);
+	for (i = 0; i < 19; i++)
+	{
+		index = jsmnreader_token_array(i, 0, &reader);
+		CHECK(jsmnreader_token_copy_string(index, buffer, sizeof(buffer), &reader) > 0);
+		if ((reader.tokens + index)->type != JSMN_PRIMITIVE || buffer[0] == 't')
+		{
+			CHECK(float_values[i] == 0 && double_values[i] == 0);
+			continue;
+		}
+		//The same rounding as jsmnreader_token_get_float(), strtof() and strtod(), within range
+		CHECK(i == 17 || i == 18 || float_values[i] == strtof(buffer, NULL));
+		CHECK(i == 17 || i == 18 || float_values[i] == jsmnreader_token_get_float(index, &reader));
+		CHECK(i == 18 || double_values[i] == strtod(buffer, NULL));
+	}
+	CHECK(float_values[17] == 0 && float_values[18] == 0 && double_values[18] == 0);
+	CHECK(jsmnreader_token_array_get_float(float_values, 17, &error_index, 0, &reader) == 19 && error_index == 12);
+
+	//Just past halfway between two floats, where rounding to a double first would round to even instead
+	CHECK(test_load("[1.0000000596046447753906251,-3.0000002048000001e10]", &reader) == JSMN_SUCCESS);
+	CHECK(jsmnreader_token_array_get_float(float_values, 2, &error_index, 0, &reader) == 2 && error_index == (unsigned int)-1);
+	CHECK(float_values[0] == strtof("1.0000000596046447753906251", NULL) && float_values[0] != 1.0f);
+	CHECK(float_values[1] == strtof("-3.0000002048000001e10", NULL) && float_values[1] != -30000001024.0f);
+	CHECK(jsmnreader_token_get_float(1, &reader) == float_values[0]);
+	CHECK(jsmnreader_token_get_float(2, &reader) == float_values[1]);
+	CHECK(test_load(json, &reader) == JSMN_SUCCESS);
+
+	//Only as much as fits, and nothing wrong within it
+	int_values[3] = 12345;
+	CHECK(jsmnreader_token_array_get_int32(int_values, 3, &error_index, 0, &reader) == 19);
+	CHECK(error_index == (unsigned int)-1 && int_values[2] == 1 && int_values[3] == 12345);
+	CHECK(jsmnreader_token_array_get_double(double_values, 19, NULL, 0, &reader) == 19);
+	CHECK(jsmnreader_token_array_get_int32(int_values, 19, &error_index, 13, &reader) == 0 && error_index == (unsigned int)-1);
+
+	//Random decimals within a float's range, down to where floats lose precision
+	json_random = (char *)malloc(2000 * 40 + 2);
+	size = 0;
+	json_random[size++] = '[';
+	for (i = 0; i < 2000; i++)
+	{
+		if (test_random() % 2)
+			json_random[size++] = '-';
+		json_random[size++] = (char)('1' + test_random() % 9);
+		for (k = test_random() % 18; k > 0; k--)
+			json_random[size++] = (char)('0' + test_random() % 10);
+		if (test_random() % 2)
+		{
+			json_random[size++] = '.';
+			for (k = 1 + test_random() % 10; k > 0; k--)
+				json_random[size++] = (char)('0' + test_random() % 10);
+		}
+		if (test_random() % 2)
+			size += sprintf(json_random + size, "e%d", (int)(test_random() % 70) - 50);
+		json_random[size++] = ',';
+	}
+	json_random[size - 1] = ']';
+	json_random[size] = '\0';
+	CHECK(test_load(json_random, &reader) == JSMN_SUCCESS);
+	random_floats = (float *)malloc(2000 * sizeof(float));
+	random_doubles = (double *)malloc(2000 * sizeof(double));
+	CHECK(jsmnreader_token_array_get_float(random_floats, 2000, &error_index, 0, &reader) == 2000 && error_index == (unsigned int)-1);
+	CHECK(jsmnreader_token_array_get_double(random_doubles, 2000, &error_index, 0, &reader) == 2000 && error_index == (unsigned int)-1);
+	mismatches = 0;
+	for (i = 0; i < 2000; i++)
+	{
+		index = jsmnreader_token_array(i, 0, &reader);
+		jsmnreader_token_copy_string(index, buffer, sizeof(buffer), &reader);
+		if (random_floats[i] != strtof(buffer, NULL) || random_floats[i] != jsmnreader_token_get_float(index, &reader) || random_doubles[i] != strtod(buffer, NULL))
+		{
+			if (mismatches++ < 10)
+				printf("%s:%d: failed: %s read as %.9g and %.17g\n", __FILE__, __LINE__, buffer, random_floats[i], random_doubles[i]);
+		}
+	}
+	CHECK(mismatches == 0);
+	free(random_floats);
+	free(random_doubles);
+	free(json_random);
+
+	jsmnreader_free(&reader);
+}
+
+/* ---- SIDECAR INDEXES ---- */
+
+#ifdef JSMNR_SIDECAR
+//Writes over the sidecar's copy of a token, as a damaged or tampered index would
+static void test_sidecar_damage(unsigned int index, int type, int start, int end, int size)
+{
+	FILE * file;
+	jsmntok_t token;
+	file = fopen("test_sidecar.json.jsmnr", "r+b");
+	CHECK(file != NULL);
+	if (file == NULL)
+		return;
+	CHECK(fseek(file, (long)(sizeof(jsmnreader_sidecar) + index * sizeof(jsmntok_t)), SEEK_SET) == 0 && fread(&token, sizeof(token), 1, file) == 1);
+	token.type = (jsmntype_t)type;
+	token.start = start;
+	token.end = end;
+	token.size = size;
+	CHECK(fseek(file, (long)(sizeof(jsmnreader_sidecar) + index * sizeof(jsmntok_t)), SEEK_SET) == 0 && fwrite(&token, sizeof(token), 1, file) == 1);
+	fclose(file);
+}
+
+static void test_sidecar(void)
+{
+	jsmnreader_obj reader;
+	char buffer[16];
+	int damage;
+
+	remove("test_sidecar.json.jsmnr");
+	test_write_file("test_sidecar.json", "{\"a\":\"hello\",\"b\":[1,2]}");
+	test_init(&reader);
+
+	//The first load parses and writes the index, the next maps it back in
+	CHECK(jsmnreader_fileload_sidecar("test_sidecar.json", NULL, &reader) == JSMN_SUCCESS);
+	CHECK(reader.map_index == NULL);
+	CHECK(jsmnreader_tree_copy_string("a", 0, buffer, sizeof(buffer), &reader) == 5 && strcmp(buffer, "hello") == 0);
+	CHECK(jsmnreader_fileload_sidecar("test_sidecar.json", NULL, &reader) == JSMN_SUCCESS);
+	CHECK(reader.map_index != NULL);
+	CHECK(jsmnreader_tree_copy_string("a", 0, buffer, sizeof(buffer), &reader) == 5 && strcmp(buffer, "hello") == 0);
+	CHECK(jsmnreader_tree_get_int("b\\1", 0, &reader) == 2);
+	//Mapped pages are private, so decoding in place leaves the file alone
+	jsmnreader_insitu(&reader);
+	CHECK(strcmp(jsmnreader_tree_get_insitu("a", 0, &reader), "hello") == 0);
+
+	//A changed file is parsed again, and its new index used from then on
+	test_write_file("test_sidecar.json", "{\"a\":\"changed\",\"b\":[3,4,5]}");
+	CHECK(jsmnreader_fileload_sidecar("test_sidecar.json", NULL, &reader) == JSMN_SUCCESS);
+	CHECK(reader.map_index == NULL);
+	CHECK(jsmnreader_tree_copy_string("a", 0, buffer, sizeof(buffer), &reader) == 7 && strcmp(buffer, "changed") == 0);
+	CHECK(jsmnreader_fileload_sidecar("test_sidecar.json", NULL, &reader) == JSMN_SUCCESS);
+	CHECK(reader.map_index != NULL);
+	CHECK(jsmnreader_tree_get_int("b\\2", 0, &reader) == 5);
+
+	//A damaged token is never used: the file is parsed, and the index written again
+	for (damage = 0; damage < 5; damage++)
+	{
+		switch (damage)
+		{
+		case 0:
+			test_sidecar_damage(2, JSMN_STRING, 100000000, 100000000, 0);
+			break;
+		case 1:
+			test_sidecar_damage(2, JSMN_STRING, 7, 5, 0);
+			break;
+		case 2:
+			test_sidecar_damage(2, JSMN_STRING, -1, 5, 0);
+			break;
+		case 3:
+			test_sidecar_damage(3, JSMN_ARRAY, 17, 26, 1000);
+			break;
+		default:
+			test_sidecar_damage(2, 0x40, 6, 13, 0);
+			break;
+		}
+		CHECK(jsmnreader_fileload_sidecar("test_sidecar.json", NULL, &reader) == JSMN_SUCCESS);
+		CHECK(reader.map_index == NULL);
+		CHECK(jsmnreader_tree_copy_string("a", 0, buffer, sizeof(buffer), &reader) == 7 && strcmp(buffer, "changed") == 0);
+		CHECK(jsmnreader_tree_get_int("b\\2", 0, &reader) == 5);
+		CHECK(jsmnreader_fileload_sidecar("test_sidecar.json", NULL, &reader) == JSMN_SUCCESS);
+		CHECK(reader.map_index != NULL);
+		CHECK(jsmnreader_tree_copy_string("a", 0, buffer, sizeof(buffer), &reader) == 7 && strcmp(buffer, "changed") == 0);
+	}
+
+	//A missing file is an error, not a stale index
+	remove("test_sidecar.json");
+	CHECK(jsmnreader_fileload_sidecar("test_sidecar.json", NULL, &reader) == JSMN_ERROR_NOFILE);
+	remove("test_sidecar.json.jsmnr");
+	jsmnreader_free(&reader);
+}
+#endif
+
+/* ---- DOCUMENT CACHE ---- */
+
+#ifdef JSMNR_CACHE
+#define TEST_CACHE_FILES 40
+
+static void test_cache_path(char * path, unsigned int file)
+{
+	sprintf(path, "test_cache_%u.json", file);
+}
+
+//Loads, queries and releases the cached files over and over, alongside the other threads
+static void * test_cache_thread(void * userdata)
+{
+	jsmnreader_obj * reader;
+	char path[32];
+	unsigned int * failures;
+	unsigned int i;
+	int error;
+	failures = (unsigned int *)userdata;
+	for (i = 0; i < 400; i++)
+	{
+		test_cache_path(path, i % 8);
+		reader = jsmnreader_cache_fileload(path, &error);
+		if (reader == NULL || error != JSMN_SUCCESS || jsmnreader_tree_get_int("n", 0, reader) != (int)(i % 8))
+			(*failures)++;
+		jsmnreader_cache_release(reader);
+	}
+	return NULL;
+}
+
+static void test_cache(void)
+{
+	jsmnreader_obj * first;
+	jsmnreader_obj * again;
+	jsmnreader_cache_stats before;
+	jsmnreader_cache_stats stats;
+	pthread_t threads[4];
+	unsigned int failures[4];
+	char path[32];
+	char json[32];
+	unsigned int i;
+	int error;
+
+	for (i = 0; i < TEST_CACHE_FILES; i++)
+	{
+		test_cache_path(path, i);
+		sprintf(json, "{\"n\":%u}", i);
+		test_write_file(path, json);
+	}
+	jsmnreader_cache_clear();
+	jsmnreader_cache_stats_get(&before);
+	CHECK(before.entries == 0 && before.bytes == 0 && before.budget == JSMNR_CACHE_BUDGET);
+
+	//A second load is the same frozen reader, until the file changes
+	first = jsmnreader_cache_fileload("test_cache_0.json", &error);
+	CHECK(first != NULL && error == JSMN_SUCCESS);
+	if (first == NULL)
+		return;
+	CHECK(first->frozen && jsmnreader_tree_get_int("n", 0, first) == 0);
+	again = jsmnreader_cache_fileload("test_cache_0.json", NULL);
+	CHECK(again == first);
+	jsmnreader_cache_release(again);
+	jsmnreader_cache_stats_get(&stats);
+	CHECK(stats.hits == before.hits + 1 && stats.misses == before.misses + 1);
+	CHECK(stats.entries == 1 && stats.bytes > 0);
+
+	//A changed file is loaded again, while the old document stays valid until released
+	test_write_file("test_cache_0.json", "{\"n\":1000}");
+	again = jsmnreader_cache_fileload("test_cache_0.json", &error);
+	CHECK(again != NULL && again != first && error == JSMN_SUCCESS);
+	CHECK(jsmnreader_tree_get_int("n", 0, again) == 1000);
+	CHECK(jsmnreader_tree_get_int("n", 0, first) == 0);
+	jsmnreader_cache_stats_get(&stats);
+	CHECK(stats.entries == 1 && stats.misses == before.misses + 2);
+	jsmnreader_cache_release(first);
+	jsmnreader_cache_release(again);
+	test_write_file("test_cache_0.json", "{\"n\":0}");
+
+	//Files that don't load are never cached
+	CHECK(jsmnreader_cache_fileload("test_cache_missing.json", &error) == NULL && error == JSMN_ERROR_NOFILE);
+	test_write_file("test_cache_bad.json", "{\"n\":[1,2}");
+	CHECK(jsmnreader_cache_fileload("test_cache_bad.json", &error) == NULL && error == JSMN_ERROR_INVAL);
+	remove("test_cache_bad.json");
+	jsmnreader_cache_stats_get(&stats);
+	CHECK(stats.entries == 1);
+
+	//Every file is found again among many, and clear drops them all
+	for (i = 0; i < TEST_CACHE_FILES * 2; i++)
+	{
+		test_cache_path(path, i % TEST_CACHE_FILES);
+		again = jsmnreader_cache_fileload(path, &error);
+		CHECK(again != NULL && jsmnreader_tree_get_int("n", 0, again) == (int)(i % TEST_CACHE_FILES));
+		jsmnreader_cache_release(again);
+	}
+	jsmnreader_cache_stats_get(&stats);
+	CHECK(stats.entries == TEST_CACHE_FILES);
+	CHECK(stats.misses == before.misses + 3 + TEST_CACHE_FILES);
+	jsmnreader_cache_clear();
+	jsmnreader_cache_stats_get(&stats);
+	CHECK(stats.entries == 0 && stats.bytes == 0);
+
+	//Past the budget, documents nobody holds are evicted, least recently used first
+	jsmnreader_cache_budget(0);
+	first = jsmnreader_cache_fileload("test_cache_1.json", NULL);
+	again = jsmnreader_cache_fileload("test_cache_2.json", NULL);
+	jsmnreader_cache_stats_get(&before);
+	CHECK(before.entries == 2 && before.budget == 0);
+	jsmnreader_cache_release(again);
+	jsmnreader_cache_stats_get(&stats);
+	CHECK(stats.entries == 1 && stats.evictions == before.evictions + 1);
+	CHECK(jsmnreader_tree_get_int("n", 0, first) == 1);
+	jsmnreader_cache_release(first);
+	jsmnreader_cache_stats_get(&stats);
+	CHECK(stats.entries == 0 && stats.evictions == before.evictions + 2);
+	first = jsmnreader_cache_fileload("test_cache_1.json", NULL);
+	jsmnreader_cache_stats_get(&stats);
+	//The single digit files all take the same room, so this keeps two of them
+	jsmnreader_cache_budget(stats.bytes * 2);
+	jsmnreader_cache_release(first);
+	jsmnreader_cache_release(jsmnreader_cache_fileload("test_cache_2.json", NULL));
+	jsmnreader_cache_release(jsmnreader_cache_fileload("test_cache_1.json", NULL));
+	jsmnreader_cache_release(jsmnreader_cache_fileload("test_cache_3.json", NULL));
+	jsmnreader_cache_stats_get(&before);
+	CHECK(before.entries == 2 && before.bytes <= before.budget);
+	jsmnreader_cache_release(jsmnreader_cache_fileload("test_cache_1.json", NULL));
+	jsmnreader_cache_stats_get(&stats);
+	CHECK(stats.hits == before.hits + 1 && stats.misses == before.misses);
+	jsmnreader_cache_release(jsmnreader_cache_fileload("test_cache_2.json", NULL));
+	jsmnreader_cache_stats_get(&stats);
+	CHECK(stats.misses == before.misses + 1);
+	jsmnreader_cache_budget(JSMNR_CACHE_BUDGET);
+
+	//Any thread can use it at once
+	for (i = 0; i < 4; i++)
+	{
+		failures[i] = 0;
+		CHECK(pthread_create(&threads[i], NULL, test_cache_thread, &failures[i]) == 0);
+	}
+	for (i = 0; i < 4; i++)
+	{
+		pthread_join(threads[i], NULL);
+		CHECK(failures[i] == 0);
+	}
+	jsmnreader_cache_stats_get(&stats);
+	CHECK(stats.entries == 8);
+
+	jsmnreader_cache_clear();
+	for (i = 0; i < TEST_CACHE_FILES; i++)
+	{
+		test_cache_path(path, i);
+		remove(path);
+	}
+}
+#endif
+
+/* ---- FREEZE ---- */
+
+#define TEST_FREEZE_LISTS 8
+#define TEST_FREEZE_ITEMS 50
+
+//Checks every element of the frozen lists, by path and by index, returning how many were wrong
+static unsigned int test_freeze_query(jsmnreader_obj * reader)
+{
+	char path[32];
+	unsigned int failures;
+	unsigned int list;
+	unsigned int i;
+	unsigned int l;
+	unsigned int item;
+	failures = 0;
+	if (jsmnreader_tree_get_int("a\\b", 0, reader) != 1 || jsmnreader_tree_get_int("c", 0, reader) != 2)
+		failures++;
+	l = jsmnreader_tree_get_x("lists", 0, reader);
+	for (list = 0; list < TEST_FREEZE_LISTS; list++)
+	{
+		for (i = 0; i < TEST_FREEZE_ITEMS; i++)
+		{
+			sprintf(path, "lists\\%u\\%u", list, i);
+			if (jsmnreader_tree_get_int(path, 0, reader) != (int)(list * 1000 + i))
+				failures++;
+			item = jsmnreader_token_array(i, jsmnreader_token_array(list, l, reader), reader);
+			if (jsmnreader_token_get_int(item, reader) != (int)(list * 1000 + i))
+				failures++;
+		}
+	}
+	return failures;
+}
+
+#ifdef TEST_THREADS
+typedef struct test_freeze_job_struct
+{
+	jsmnreader_obj * reader;
+	unsigned int failures;
+} test_freeze_job;
+
+static void * test_freeze_thread(void * userdata)
+{
+	test_freeze_job * job;
+	unsigned int i;
+	job = (test_freeze_job *)userdata;
+	for (i = 0; i < 20; i++)
+		job->failures += test_freeze_query(job->reader);
+	return NULL;
+}
+#endif
+
+static void test_freeze(void)
+{
+	jsmnreader_obj reader;
+#ifdef JSMNR_STATS
+	jsmnreader_stats before;
+	jsmnreader_stats stats;
+#endif
+#ifdef JSMNR_PATH_CACHE
+	unsigned int remembered;
+#endif
+#ifdef TEST_THREADS
+	pthread_t threads[4];
+	test_freeze_job jobs[4];
+#endif
+	char json[16384];
+	size_t size;
+	unsigned int list;
+	unsigned int i;
+
+	size = (size_t)sprintf(json, "{\"a\":{\"b\":1},\"c\":2,\"lists\":[");
+	for (list = 0; list < TEST_FREEZE_LISTS; list++)
+	{
+		if (list > 0)
+			json[size++] = ',';
+		json[size++] = '[';
+		for (i = 0; i < TEST_FREEZE_ITEMS; i++)
+			size += (size_t)sprintf(json + size, (i > 0) ? ",%u" : "%u", list * 1000 + i);
+		json[size++] = ']';
+	}
+	strcpy(json + size, "]}");
+
+	test_init(&reader);
+	CHECK(test_load(json, &reader) == JSMN_SUCCESS);
+	CHECK(!reader.frozen);
+	//Looked up once before freezing, so the path cache can answer it afterwards
+	CHECK(jsmnreader_tree_get_int("a\\b", 0, &reader) == 1);
+	jsmnreader_freeze(&reader);
+	CHECK(reader.frozen);
+#ifdef JSMNR_STATS
+	jsmnreader_stats_get(&reader, &before);
+#endif
+#ifdef JSMNR_PATH_CACHE
+	remembered = reader.path_count;
+#endif
+
+	//Frozen queries give the same answers, without counting or remembering anything
+	CHECK(test_freeze_query(&reader) == 0);
+	CHECK(test_freeze_query(&reader) == 0);
+#ifdef JSMNR_STATS
+	jsmnreader_stats_get(&reader, &stats);
+	CHECK(stats.lookups == before.lookups && stats.path_cache_hits == before.path_cache_hits && stats.path_cache_misses == before.path_cache_misses);
+#endif
+#ifdef JSMNR_PATH_CACHE
+	CHECK(reader.path_count == remembered);
+#endif
+
+#ifdef TEST_THREADS
+	//Any number of threads can query it at once
+	for (i = 0; i < 4; i++)
+	{
+		jobs[i].reader = &reader;
+		jobs[i].failures = 0;
+		CHECK(pthread_create(&threads[i], NULL, test_freeze_thread, &jobs[i]) == 0);
+	}
+	for (i = 0; i < 4; i++)
+	{
+		pthread_join(threads[i], NULL);
+		CHECK(jobs[i].failures == 0);
+	}
+#endif
+
+	//The next load thaws it, and counting starts again
+	CHECK(test_load("{\"c\":3}", &reader) == JSMN_SUCCESS);
+	CHECK(!reader.frozen);
+	CHECK(jsmnreader_tree_get_int("c", 0, &reader) == 3);
+#ifdef JSMNR_STATS
+	jsmnreader_stats_get(&reader, &stats);
+	CHECK(stats.lookups == before.lookups + 1);
+#endif
+	jsmnreader_freeze(&reader);
+	jsmnreader_reset(&reader);
+	CHECK(!reader.frozen);
+
+	//Freezing an empty reader is harmless
+	jsmnreader_freeze(&reader);
+	CHECK(jsmnreader_tree_get_x("c", 0, &reader) == (unsigned int)-1);
+	jsmnreader_free(&reader);
+}
+
+/* ---- BATCH ---- */
+
+#ifdef JSMNR_BATCH
+#define TEST_BATCH_DOCS 500
+#define TEST_BATCH_NAME 8
+
+static char test_batch_text[TEST_BATCH_DOCS][96];
+static char * test_batch_docs[TEST_BATCH_DOCS];
+static unsigned int test_batch_sizes[TEST_BATCH_DOCS];
+static int test_batch_ints[TEST_BATCH_DOCS];
+static unsigned int test_batch_uints[TEST_BATCH_DOCS];
+static float test_batch_floats[TEST_BATCH_DOCS];
+static char test_batch_names[TEST_BATCH_DOCS][TEST_BATCH_NAME];
+static unsigned char test_batch_found[4][TEST_BATCH_DOCS];
+static int test_batch_status[TEST_BATCH_DOCS];
+
+//Documents with every column, some without one, some holding the wrong type, and some that don't load
+static void test_batch_make(void)
+{
+	unsigned int doc;
+	for (doc = 0; doc < TEST_BATCH_DOCS; doc++)
+	{
+		if (doc % 13 == 5)
+			sprintf(test_batch_text[doc], "{\"id\":%d,\"n\":", -(int)doc);
+		else if (doc % 11 == 3)
+			sprintf(test_batch_text[doc], "{\"id\":\"%d\",\"f\":%u.25,\"user\":{\"name\":[1]}}", -(int)doc, doc);
+		else if (doc % 7 == 2)
+			sprintf(test_batch_text[doc], "{\"user\":{\"name\":\"u%u\"},\"id\":%d}", doc, -(int)doc);
+		else
+			sprintf(test_batch_text[doc], "{\"id\":%d,\"n\":%u,\"f\":%u.25,\"user\":{\"name\":\"user_%u\"}}", -(int)doc, doc * 3, doc, doc);
+		test_batch_docs[doc] = test_batch_text[doc];
+		test_batch_sizes[doc] = (unsigned int)strlen(test_batch_text[doc]);
+	}
+}
+
+//Checks each document's entries against looking its paths up one document at a time, returning how many loaded
+static unsigned int test_batch_agrees(unsigned int first, unsigned int count, jsmnreader_batch_column * columns)
+{
+	jsmnreader_obj reader;
+	char name[TEST_BATCH_NAME];
+	unsigned int loaded;
+	unsigned int doc;
+	unsigned int loc;
+	unsigned int c;
+	int check;
+	int found;
+	loaded = 0;
+	test_init(&reader);
+	for (doc = 0; doc < count; doc++)
+	{
+		check = jsmnreader_load_mode(test_batch_docs[first + doc], test_batch_sizes[first + doc], JSMNR_LOAD_BORROW, &reader);
+		CHECK(test_batch_status[doc] == check);
+		if (check == JSMN_SUCCESS)
+			loaded++;
+		for (c = 0; c < 4; c++)
+		{
+			loc = (check == JSMN_SUCCESS) ? jsmnreader_tree_get_x(columns[c].path, 0, &reader) : (unsigned int)-1;
+			found = (loc != (unsigned int)-1 && (reader.tokens[loc].type == JSMN_PRIMITIVE || (reader.tokens[loc].type == JSMN_STRING && columns[c].type == JSMNR_BATCH_STRING)));
+			if (columns[c].found[doc] != found)
+			{
+				printf("%s:%d: failed: column %u found %u for document %u\n", __FILE__, __LINE__, c, columns[c].found[doc], first + doc);
+				test_failures++;
+			}
+		}
+		CHECK(test_batch_ints[doc] == (test_batch_found[0][doc] ? jsmnreader_tree_get_int("id", 0, &reader) : 0));
+		CHECK(test_batch_uints[doc] == (test_batch_found[1][doc] ? jsmnreader_tree_get_uint("n", 0, &reader) : 0));
+		CHECK(test_batch_floats[doc] == (test_batch_found[2][doc] ? jsmnreader_tree_get_float("f", 0, &reader) : 0));
+		if (!test_batch_found[3][doc])
+			name[0] = '\0';
+		else
+			jsmnreader_tree_copy_string("user\\name", 0, name, TEST_BATCH_NAME, &reader);
+		CHECK(strcmp(test_batch_names[doc], name) == 0);
+	}
+	jsmnreader_free(&reader);
+	return loaded;
+}
+
+static void test_batch(void)
+{
+	jsmnreader_batch_column columns[4] = {
+		{ "id", JSMNR_BATCH_INT, test_batch_ints, 0, test_batch_found[0] },
+		{ "n", JSMNR_BATCH_UINT, test_batch_uints, 0, test_batch_found[1] },
+		{ "f", JSMNR_BATCH_FLOAT, test_batch_floats, 0, test_batch_found[2] },
+		{ "user\\name", JSMNR_BATCH_STRING, test_batch_names, TEST_BATCH_NAME, test_batch_found[3] },
+	};
+	jsmnreader_batch batch;
+	unsigned int threads[3] = { 1, 4, 0 };
+	unsigned int t;
+	unsigned int loaded;
+
+	test_batch_make();
+	for (t = 0; t < 3; t++)
+	{
+		CHECK(jsmnreader_batch_init(columns, 4, threads[t], &batch) == JSMN_SUCCESS);
+		CHECK(threads[t] == 0 || batch.workers_count == threads[t]);
+		memset(test_batch_found, 0xFF, sizeof(test_batch_found));
+		memset(test_batch_status, 0x7F, sizeof(test_batch_status));
+		loaded = jsmnreader_batch_run(test_batch_docs, test_batch_sizes, TEST_BATCH_DOCS, test_batch_status, &batch);
+		CHECK(loaded == test_batch_agrees(0, TEST_BATCH_DOCS, columns));
+		CHECK(loaded < TEST_BATCH_DOCS && loaded > TEST_BATCH_DOCS / 2);
+		CHECK(test_batch_found[3][0] && strcmp(test_batch_names[0], "user_0") == 0);
+		CHECK(test_batch_found[3][101] && strcmp(test_batch_names[101], "user_10") == 0);
+		CHECK(!test_batch_found[0][3] && !test_batch_found[3][3] && test_batch_found[2][3]);
+		CHECK(!test_batch_found[1][2] && test_batch_ints[2] == -2);
+		CHECK(test_batch_status[5] == JSMN_ERROR_PART && !test_batch_found[0][5]);
+
+		//Runs again over other documents, with the columns pointed elsewhere, and without any status
+		columns[3].found = NULL;
+		loaded = jsmnreader_batch_run(test_batch_docs + 1, test_batch_sizes + 1, 40, NULL, &batch);
+		columns[3].found = test_batch_found[3];
+		CHECK(test_batch_ints[0] == -1 && test_batch_ints[39] == -40);
+		CHECK(loaded == 40 - 3); //Documents 5, 18 and 31 end early
+		CHECK(jsmnreader_batch_run(test_batch_docs, test_batch_sizes, 0, NULL, &batch) == 0);
+		jsmnreader_batch_free(&batch);
+		CHECK(batch.workers == NULL);
+	}
+}
+#endif
+
+int main(void)
+{
+	test_paths();
+	test_arrays();
+	test_iterators();
+	test_fills();
+#ifdef JSMNR_STATS
+	test_stats();
+#endif
+#ifdef JSMNR_TRACE
+	test_trace();
+#endif
+#ifndef JSMNR_NO_HEAP
+	test_reuse();
+	test_load_modes();
+#endif
+	test_subtypes();
+	test_escapes();
+	test_insitu();
+	test_validate();
+	test_utf8();
+	test_dataskip();
+#ifdef JSMNR_NO_HEAP
+	test_no_heap();
+#endif
+	test_estimate();
+	test_path_cache();
+	test_columns();
+	test_numbers();
+#ifdef JSMNR_SIDECAR
+	test_sidecar();
+#endif
+#ifdef JSMNR_CACHE
+	test_cache();
+#endif
+	test_freeze();
+#ifdef JSMNR_BATCH
+	test_batch();
+#endif
+
+	if (test_failures)
+	{
+		printf("%u checks failed\n", test_failures);
+		return EXIT_FAILURE;
+	}
+	printf("All checks passed\n");
+	return EXIT_SUCCESS;
+}